@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace xorLang::bench {
+    // Shapes of synthetic source, each modelled on what libstd/src looks like
+    // when one kind of content dominates.
+    enum class Mix {
+        MIXED, IDENTIFIER, COMMENT, STRING, NESTING, PLATFORM
+    };
+
+    inline std::optional<Mix> parseMix(std::string_view name) {
+        if (name == "mixed")
+            return Mix::MIXED;
+        else if (name == "identifier")
+            return Mix::IDENTIFIER;
+        else if (name == "comment")
+            return Mix::COMMENT;
+        else if (name == "string")
+            return Mix::STRING;
+        else if (name == "nesting")
+            return Mix::NESTING;
+        else if (name == "platform")
+            return Mix::PLATFORM;
+
+        return std::nullopt;
+    }
+
+    inline std::string_view mixName(Mix mix) {
+        switch (mix) {
+            case Mix::MIXED:
+                return "mixed";
+            case Mix::IDENTIFIER:
+                return "identifier";
+            case Mix::COMMENT:
+                return "comment";
+            case Mix::STRING:
+                return "string";
+            case Mix::NESTING:
+                return "nesting";
+            case Mix::PLATFORM:
+                return "platform";
+        }
+
+        return "mixed";
+    }
+
+    // Generates roughly `size` bytes of `.xor` source. The same seed always
+    // produces the same corpus, so runs on different commits are comparable.
+    class CorpusGenerator {
+        std::mt19937_64 random;
+        std::string out;
+        size_t depth = 0;
+
+        size_t pick(size_t bound) {
+            return static_cast<size_t>(random() % bound);
+        }
+
+        void indent() {
+            out.append(depth * 4, ' ');
+        }
+
+        std::string identifier() {
+            static constexpr std::string_view words[] = {
+                    "String", "str", "Terminal", "TcpServer", "text", "ext", "buffer", "length",
+                    "TcpServerLinux", "TcpServerAbstract", "value", "index", "count", "result"
+            };
+
+            std::string name(words[pick(std::size(words))]);
+
+            if (pick(3) == 0)
+                name += std::to_string(pick(1000));
+
+            return name;
+        }
+
+        std::string type() {
+            static constexpr std::string_view types[] = {"i8", "i32", "u64", "char[]", "bool", "f64"};
+
+            if (pick(3) == 0)
+                return identifier();
+
+            return std::string(types[pick(std::size(types))]);
+        }
+
+        std::string number() {
+            static constexpr std::string_view numbers[] = {
+                    "0", "1", "42", "1_000_000", "0xFF_FF", "0b1010", "255u8", "3.14159", "6.02e+23", "0.5f32",
+                    "18446744073709551615u64", "'a'", "'\\n'"
+            };
+
+            return std::string(numbers[pick(std::size(numbers))]);
+        }
+
+        void comment() {
+            static constexpr std::string_view sentences[] = {
+                    "This is a string class that stores an array of characters in a higher",
+                    "level interfacing style. This unit encapsulates direct strings.",
+                    "Initialize a new string from a native direct string.",
+                    "@param str The input direct string."
+            };
+
+            indent();
+            out += pick(2) == 0 ? "/// " : "// ";
+            out += sentences[pick(std::size(sentences))];
+            out += '\n';
+        }
+
+        void string() {
+            static constexpr std::string_view pieces[] = {
+                    "Hello World", "\\\"quoted\\\"", "tab\\tseparated", "line\\n", "path\\\\to\\\\file", " "
+            };
+
+            char quote = pick(4) == 0 ? '`' : '"';
+            out += quote;
+
+            for (size_t i = 0, count = 1 + pick(6); i < count; i++)
+                out += pieces[pick(std::size(pieces))];
+
+            out += quote;
+        }
+
+        void statement(Mix mix) {
+            indent();
+
+            if (mix == Mix::STRING || (mix == Mix::MIXED && pick(4) == 0)) {
+                out += identifier() + " += ";
+                string();
+                out += ";\n";
+            } else if (pick(2) == 0) {
+                out += "return " + identifier() + " + " + (pick(2) == 0 ? number() : identifier()) + ";\n";
+            } else {
+                out += "this." + identifier() + " = " + identifier() + "(" + identifier() + ", " + identifier() + ");\n";
+            }
+        }
+
+        void function(Mix mix) {
+            if (mix == Mix::COMMENT || (mix == Mix::MIXED && pick(2) == 0)) {
+                for (size_t i = 0, count = 1 + pick(mix == Mix::COMMENT ? 6 : 2); i < count; i++)
+                    comment();
+            }
+
+            indent();
+            out += pick(2) == 0 ? "pub fn " : "fn ";
+            out += identifier() + "(" + identifier() + ": " + type() + ") -> " + type() + " {\n";
+            depth++;
+
+            for (size_t i = 0, count = 1 + pick(4); i < count; i++) {
+                if (mix == Mix::NESTING && depth < 24 && pick(2) == 0)
+                    nested();
+                else if (mix == Mix::PLATFORM && pick(2) == 0)
+                    platforms();
+                else
+                    statement(mix);
+            }
+
+            depth--;
+            indent();
+            out += "}\n\n";
+        }
+
+        void nested() {
+            indent();
+            out += "if ((" + identifier() + ")) {\n";
+            depth++;
+
+            if (depth < 24 && pick(3) != 0)
+                nested();
+            else
+                statement(Mix::NESTING);
+
+            depth--;
+            indent();
+            out += "}\n";
+        }
+
+        // A branch per platform like io/terminal.xor, of which the host
+        // target only ever takes the first.
+        void platforms() {
+            static constexpr std::string_view systems[] = {"Linux", "macOS", "Windows", "FreeBSD"};
+
+            for (std::string_view system : systems) {
+                indent();
+                out += "#[if os == \"";
+                out += system;
+                out += "\"]\n";
+                depth++;
+                indent();
+                out += "#[asm]\n";
+
+                for (size_t i = 0, count = 2 + pick(6); i < count; i++) {
+                    indent();
+                    out += "    mov r" + std::to_string(pick(16)) + ", ${" + identifier() + "}\n";
+                }
+
+                indent();
+                out += "#[end asm]\n";
+                statement(Mix::MIXED);
+                depth--;
+                indent();
+                out += "#[end if]\n";
+            }
+        }
+
+        void declaration(Mix mix) {
+            if (pick(3) == 0) {
+                function(mix);
+                return;
+            }
+
+            out += pick(2) == 0 ? "pub class " : "class ";
+            out += identifier() + " {\n";
+            depth++;
+
+            for (size_t i = 0, count = 1 + pick(3); i < count; i++) {
+                indent();
+                out += "pvt mut " + identifier() + ": " + type() + ";\n";
+            }
+
+            out += '\n';
+
+            for (size_t i = 0, count = 1 + pick(4); i < count; i++)
+                function(mix);
+
+            depth--;
+            out += "}\n\n";
+        }
+
+    public:
+        explicit CorpusGenerator(uint64_t seed): random(seed) {}
+
+        std::string generate(Mix mix, size_t size) {
+            out.clear();
+            out.reserve(size + 4096);
+
+            while (out.size() < size)
+                declaration(mix);
+
+            return std::move(out);
+        }
+    };
+}
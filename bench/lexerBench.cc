@@ -0,0 +1,235 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "corpus.h"
+#include "../xor/io/sourceFile.h"
+#include "../xor/lexer/lexer.h"
+#include "../xor/lexer/parallelLexer.h"
+#include "../xor/lexer/streamLexer.h"
+#include "../xor/lexer/tokenBuffer.h"
+#include "../xor/parser/pipeline.h"
+
+// Benchmarks the lexer entry points, and lexing plus parsing, over generated
+// corpora and prints one JSON object per (path, corpus) pair, so results of
+// two commits can be diffed.
+//
+//   bench [--size=BYTES] [--mix=all|mixed|identifier|comment|string|nesting|platform]
+//         [--seed=N] [--repeat=N] [--input=FILE] [--generate=FILE]
+
+static std::atomic<size_t> allocations = 0;
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+// Kept out of line: once inlined GCC pairs the free() with the new-expression
+// rather than with the malloc() above and warns about a mismatch
+[[gnu::noinline]] void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+    using namespace xorLang;
+    using namespace xorLang::bench;
+
+    struct Options {
+        size_t size = 16 << 20;
+        std::vector<Mix> mixes = {Mix::MIXED, Mix::IDENTIFIER, Mix::COMMENT, Mix::STRING, Mix::NESTING, Mix::PLATFORM};
+        uint64_t seed = 1;
+        size_t repeat = 5;
+        std::string input;
+        std::string generate;
+    };
+
+    struct Sample {
+        double seconds;
+        size_t tokens;
+        size_t allocations;
+    };
+
+    long peakRssKb() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    // Runs `path` `repeat` times and keeps the fastest run.
+    Sample measure(size_t repeat, const std::function<size_t()> &path) {
+        Sample best{1e300, 0, 0};
+
+        for (size_t i = 0; i < repeat; i++) {
+            size_t before = allocations.load(std::memory_order_relaxed);
+            auto start = std::chrono::steady_clock::now();
+            size_t tokens = path();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            if (elapsed.count() < best.seconds)
+                best = Sample{elapsed.count(), tokens, allocations.load(std::memory_order_relaxed) - before};
+        }
+
+        return best;
+    }
+
+    void report(std::string_view path, std::string_view corpus, size_t bytes, const Sample &sample) {
+        double tokens = static_cast<double>(std::max<size_t>(sample.tokens, 1));
+
+        std::printf("{\"path\":\"%.*s\",\"corpus\":\"%.*s\",\"isa\":%d,\"bytes\":%zu,\"tokens\":%zu,"
+                    "\"seconds\":%.6f,\"mb_per_s\":%.1f,\"tokens_per_s\":%.0f,\"allocs_per_token\":%.6f,"
+                    "\"peak_rss_kb\":%ld}\n",
+                    static_cast<int>(path.size()), path.data(), static_cast<int>(corpus.size()), corpus.data(),
+                    static_cast<int>(scanIsa()), bytes, sample.tokens, sample.seconds,
+                    static_cast<double>(bytes) / 1e6 / sample.seconds, tokens / sample.seconds,
+                    static_cast<double>(sample.allocations) / tokens, peakRssKb());
+        std::fflush(stdout);
+    }
+
+    void run(const Options &options, std::string_view corpus, std::string_view source, ThreadPool &pool) {
+        report("next", corpus, source.length(), measure(options.repeat, [&] {
+            Lexer lexer(source);
+            size_t tokens = 0;
+
+            while (lexer.hasNext()) {
+                lexer.next();
+                tokens++;
+            }
+
+            return tokens;
+        }));
+
+        report("lexAll", corpus, source.length(), measure(options.repeat, [&] {
+            return lexAll(source).size();
+        }));
+
+        report("lexAll+intern", corpus, source.length(), measure(options.repeat, [&] {
+            SymbolTable symbols;
+            return lexAll(source, &symbols).size();
+        }));
+
+        report("lexParallel", corpus, source.length(), measure(options.repeat, [&] {
+            return lexParallel(source, pool).size();
+        }));
+
+        // Lexing and parsing one after the other against both at once
+        report("lexAll+parse", corpus, source.length(), measure(options.repeat, [&] {
+            Arena arena;
+            TokenBuffer buffer = lexAll(source);
+            parse(buffer, arena);
+            return buffer.size();
+        }));
+
+        report("parsePipelined", corpus, source.length(), measure(options.repeat, [&] {
+            Arena arena;
+            TokenBuffer buffer;
+            parsePipelined(source, buffer, arena);
+            return buffer.size();
+        }));
+
+        // The stream path reads from an in-memory file so the producer is free
+        int fd = memfd_create("xor-bench", 0);
+
+        if (fd >= 0 && write(fd, source.data(), source.length()) == static_cast<ssize_t>(source.length())) {
+            report("stream", corpus, source.length(), measure(options.repeat, [&] {
+                lseek(fd, 0, SEEK_SET);
+                StreamLexer lexer(fd);
+                size_t tokens = 0;
+
+                while (lexer.hasNext()) {
+                    lexer.next();
+                    tokens++;
+                }
+
+                return tokens;
+            }));
+        }
+
+        if (fd >= 0)
+            close(fd);
+    }
+
+    bool parse(int argc, char **argv, Options &options) {
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            std::string_view value = arg.substr(std::min(arg.find('=') + 1, arg.length()));
+
+            if (arg.starts_with("--size=")) {
+                options.size = std::stoull(std::string(value));
+            } else if (arg.starts_with("--seed=")) {
+                options.seed = std::stoull(std::string(value));
+            } else if (arg.starts_with("--repeat=")) {
+                options.repeat = std::max<size_t>(std::stoull(std::string(value)), 1);
+            } else if (arg.starts_with("--input=")) {
+                options.input = value;
+            } else if (arg.starts_with("--generate=")) {
+                options.generate = value;
+            } else if (arg.starts_with("--mix=")) {
+                if (value != "all") {
+                    std::optional<Mix> mix = parseMix(value);
+
+                    if (!mix.has_value())
+                        return false;
+
+                    options.mixes = {*mix};
+                }
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options;
+
+    if (!parse(argc, argv, options)) {
+        std::cerr << "Usage: bench [--size=BYTES] [--mix=all|mixed|identifier|comment|string|nesting|platform] "
+                     "[--seed=N] [--repeat=N] [--input=FILE] [--generate=FILE]\n";
+        return 1;
+    }
+
+    if (!options.generate.empty()) {
+        std::ofstream out(options.generate, std::ios::binary);
+        out << CorpusGenerator(options.seed).generate(options.mixes.front(), options.size);
+        return out ? 0 : 1;
+    }
+
+    ThreadPool pool;
+
+    if (!options.input.empty()) {
+        std::optional<SourceFile> file = SourceFile::open(options.input);
+
+        if (!file.has_value()) {
+            std::cerr << "Unable to open the file: " << options.input << "\n";
+            return 1;
+        }
+
+        run(options, options.input, file->view(), pool);
+        return 0;
+    }
+
+    for (Mix mix : options.mixes) {
+        std::string source = CorpusGenerator(options.seed).generate(mix, options.size);
+        run(options, mixName(mix), source, pool);
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "check.h"
+#include "../xor/driver/build.h"
+
+// A second build of an unchanged project has nothing to do, and an edit only
+// brings back the file that was edited.
+
+namespace {
+    using namespace xorLang;
+
+    struct ScratchProject {
+        std::filesystem::path root = std::filesystem::temp_directory_path() /
+                                     ("xor-build-test-" + std::to_string(getpid()));
+        BuildPlan plan;
+
+        ScratchProject() {
+            std::filesystem::create_directories(root / "src");
+            write("a.xor", "pub fn greet() {\n    print(\"hi\");\n}\n");
+            write("b.xor", "import app::a::greet;\n\nfn main() {\n    greet();\n}\n");
+
+            plan.name = "app";
+            plan.sourcesPath = root / "src";
+            plan.state = (root / "state").string();
+
+            for (const char *name : {"a.xor", "b.xor"}) {
+                std::filesystem::path path = root / "src" / name;
+                plan.sources.push_back(SourceEntry{path, std::filesystem::file_size(path)});
+            }
+        }
+
+        ~ScratchProject() {
+            std::error_code error;
+            std::filesystem::remove_all(root, error);
+        }
+
+        void write(const std::string &name, const std::string &text) const {
+            std::ofstream(root / "src" / name, std::ios::binary) << text;
+        }
+
+        BuildReport build() const {
+            ThreadPool pool(2);
+            SymbolTable symbols;
+            Profiler profiler(false);
+            BuildSettings settings;
+            return Build(plan, pool, symbols, profiler, settings).run();
+        }
+    };
+}
+
+XOR_TEST(buildSkipsUnchanged) {
+    ScratchProject project;
+
+    BuildReport first = project.build();
+    XOR_CHECK(first.files.size() == 2 && first.upToDate == 0 && first.resolved == 1);
+
+    for (const FileResult &file : first.files)
+        XOR_CHECK(file.parsed && file.errors.count() == 0);
+
+    BuildReport second = project.build();
+    XOR_CHECK(second.files.empty() && second.upToDate == 2 && second.resolved == 1);
+}
+
+XOR_TEST(buildRedoesEditedFile) {
+    ScratchProject project;
+    (void) project.build();
+
+    // Same exports, so b.xor stays up to date
+    project.write("a.xor", "pub fn greet() {\n    print(\"hello\");\n}\n");
+    BuildReport edited = project.build();
+    XOR_CHECK(edited.files.size() == 1 && edited.upToDate == 1);
+    XOR_CHECK(!edited.files.empty() && edited.files[0].path.filename() == "a.xor" && edited.files[0].parsed);
+
+    BuildReport again = project.build();
+    XOR_CHECK(again.files.empty() && again.upToDate == 2);
+}
+
+XOR_TEST(buildHashesRacilyCleanFiles) {
+    ScratchProject project;
+    (void) project.build();
+
+    // Same size and modification time, as when an edit lands within the
+    // timestamp granularity of the previous one
+    std::filesystem::path a = project.root / "src" / "a.xor";
+    auto modified = std::filesystem::last_write_time(a);
+    project.write("a.xor", "pub fn greet() {\n    print(\"ho\");\n}\n");
+    std::filesystem::last_write_time(a, modified);
+
+    // Written before the edit, the state still trusts the stat
+    std::filesystem::last_write_time(project.plan.state, modified + std::chrono::seconds(1));
+    XOR_CHECK(project.build().files.empty());
+
+    // Written in the same tick as the file, it does not
+    std::filesystem::last_write_time(project.plan.state, modified);
+    BuildReport racy = project.build();
+    XOR_CHECK(racy.files.size() == 1 && racy.upToDate == 1);
+}
@@ -0,0 +1,91 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "check.h"
+#include "../xor/driver/tokenCache.h"
+#include "../xor/lexer/tokenBuffer.h"
+
+// A cached buffer has to come back exactly as lexAll() would build it, and
+// an entry that no longer matches its file has to miss rather than load.
+
+namespace {
+    using namespace xorLang;
+
+    const std::string source = "fn main() {\n    let x = 0xFF + 1.5;\n    print(\"hi\", x);\n}\n";
+
+    struct ScratchDirectory {
+        std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                     ("xor-cache-test-" + std::to_string(getpid()));
+
+        ~ScratchDirectory() {
+            std::error_code error;
+            std::filesystem::remove_all(path, error);
+        }
+    };
+
+    bool sameTokens(const TokenBuffer &a, const TokenBuffer &b) {
+        if (a.size() != b.size())
+            return false;
+
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a.kind(i) != b.kind(i) || a.offsets[i] != b.offsets[i] || a.lengths[i] != b.lengths[i] ||
+                a.value(i) != b.value(i))
+                return false;
+
+            if (hasLiteral(a.kind(i)) && a.literal(i).low != b.literal(i).low)
+                return false;
+        }
+
+        return true;
+    }
+
+    std::filesystem::path onlyEntry(const std::filesystem::path &directory) {
+        for (const auto &file : std::filesystem::directory_iterator(directory)) {
+            if (file.path().extension() == ".tok")
+                return file.path();
+        }
+
+        return {};
+    }
+}
+
+XOR_TEST(cacheHitMatchesLex) {
+    ScratchDirectory scratch;
+    TokenCache cache(scratch.path);
+    TokenBuffer lexed = lexAll(source);
+
+    XOR_CHECK(!cache.load(source).has_value());
+    XOR_CHECK(cache.store(lexed));
+
+    std::optional<TokenBuffer> cached = cache.load(source);
+    XOR_CHECK(cached.has_value() && sameTokens(*cached, lexed));
+
+    // Any change to the source is a different key
+    XOR_CHECK(!cache.load(source + " ").has_value());
+}
+
+XOR_TEST(cacheStaleEntryMisses) {
+    ScratchDirectory scratch;
+    TokenCache cache(scratch.path);
+    XOR_CHECK(cache.store(lexAll(source)));
+
+    std::filesystem::path entry = onlyEntry(scratch.path);
+    XOR_CHECK(!entry.empty());
+
+    // Cut short, the entry no longer has the size its header promises
+    std::filesystem::resize_file(entry, std::filesystem::file_size(entry) / 2);
+    XOR_CHECK(!cache.load(source).has_value());
+
+    // A header from some other format is not read past
+    XOR_CHECK(cache.store(lexAll(source)));
+    {
+        std::fstream file(entry, std::ios::in | std::ios::out | std::ios::binary);
+        file.write("junk", 4);
+    }
+    XOR_CHECK(!cache.load(source).has_value());
+
+    // Storing again replaces the bad entry
+    XOR_CHECK(cache.store(lexAll(source)));
+    XOR_CHECK(cache.load(source).has_value());
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A minimal test registry: every file registers its cases with XOR_TEST and
+// test/main.cc runs them all. A failed XOR_CHECK is printed and counted but
+// does not stop the case, so one run shows every mismatch.
+
+namespace xorLang::test {
+    struct Case {
+        const char *name;
+        void (*run)();
+    };
+
+    inline std::vector<Case> &cases() {
+        static std::vector<Case> list;
+        return list;
+    }
+
+    inline size_t failures = 0;
+
+    struct Registration {
+        Registration(const char *name, void (*run)()) {
+            cases().push_back(Case{name, run});
+        }
+    };
+
+    inline void fail(const char *file, int line, const char *condition) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+        failures++;
+    }
+
+    // Concatenates `count` pieces picked at random, for inputs that hit the
+    // interesting cases far more often than random bytes would.
+    inline std::string soup(std::mt19937_64 &random, const std::vector<std::string_view> &pieces, size_t count) {
+        std::string text;
+
+        for (size_t i = 0; i < count; i++)
+            text += pieces[random() % pieces.size()];
+
+        return text;
+    }
+}
+
+#define XOR_TEST(name)                                                                       \
+    static void name();                                                                      \
+    static const xorLang::test::Registration name##Registration(#name, name);                \
+    static void name()
+
+#define XOR_CHECK(condition)                                                                 \
+    do {                                                                                     \
+        if (!(condition))                                                                    \
+            xorLang::test::fail(__FILE__, __LINE__, #condition);                             \
+    } while (0)
@@ -0,0 +1,80 @@
+#include <sstream>
+#include <string>
+#include "check.h"
+#include "../xor/driver/errorLog.h"
+#include "../xor/lexer/tokenBuffer.h"
+
+// Garbage input has to cost bounded memory and output: a run of bytes the
+// lexer rejects is one token, and a log keeps and locates only its first
+// `limit` errors.
+
+namespace {
+    using namespace xorLang;
+
+    size_t occurrences(const std::string &text, std::string_view part) {
+        size_t count = 0;
+
+        for (size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + 1))
+            count++;
+
+        return count;
+    }
+}
+
+XOR_TEST(invalidBytesCoalesce) {
+    std::string source = "a \x01\x02\x03\x04 b \x05";
+    TokenBuffer buffer = lexAll(source);
+    size_t invalid = 0;
+
+    for (size_t i = 0; i < buffer.size(); i++) {
+        if (buffer.kind(i) == TokenType::INVALID) {
+            invalid++;
+            XOR_CHECK(buffer.value(i) == "\x01\x02\x03\x04" || buffer.value(i) == "\x05");
+        }
+    }
+
+    XOR_CHECK(invalid == 2);
+}
+
+XOR_TEST(errorLogIsCapped) {
+    ErrorLog log(10);
+    size_t located = 0;
+
+    for (size_t offset = 0; offset < 25; offset++) {
+        log.report(LexErrorKind::UNKNOWN_TOKEN, offset, 1, [&](size_t at) {
+            located++;
+            return Position{.line = at + 1, .column = 1};
+        });
+    }
+
+    std::ostringstream out;
+    log.write(out, "file.xor");
+
+    XOR_CHECK(log.count() == 25);
+    XOR_CHECK(located == 10);
+    XOR_CHECK(occurrences(out.str(), " -- Line & Column: ") == 10);
+    XOR_CHECK(occurrences(out.str(), " -- Line & Column: 10 - 1\n") == 1);
+    XOR_CHECK(occurrences(out.str(), "15 more errors not shown in file.xor") == 1);
+}
+
+XOR_TEST(errorLogKeepsFirstInFile) {
+    ErrorLog log(3);
+    auto locate = [](size_t at) {
+        return Position{.line = at + 1, .column = 1};
+    };
+
+    // Reported out of order, as UTF-8 errors come before lex errors
+    for (size_t offset : {7, 2, 9, 0, 5, 2})
+        log.report(LexErrorKind::UNKNOWN_TOKEN, offset, 1, locate);
+
+    log.report(LexErrorKind::INVALID_UTF8, 0, 1, locate);
+
+    std::ostringstream out;
+    log.write(out);
+
+    XOR_CHECK(log.count() == 7);
+    XOR_CHECK(out.str() == "\nUnknown token found:\n -- Line & Column: 1 - 1\n"
+                           "\nInvalid UTF-8 found:\n -- Line & Column: 1 - 1\n"
+                           "\nUnknown token found:\n -- Line & Column: 3 - 1\n"
+                           "\n4 more errors not shown\n");
+}
@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "check.h"
+#include "../xor/parser/parser.h"
+#include "../xor/project/interfaceFile.h"
+
+// What writeInterface() exports has to read back the same through
+// InterfaceFile, and a damaged file has to be refused when it is opened.
+
+namespace {
+    using namespace xorLang;
+
+    const std::string source =
+            "pub class String {\n"
+            "    pvt mut str: char[];\n"
+            "    pub fn new(inline char[] str) -> String {}\n"
+            "    pub fn new() -> String {}\n"
+            "    pub cnv -> char[] {}\n"
+            "    pub op +(ext: String) -> String {}\n"
+            "}\n"
+            "fn hidden() {}\n"
+            "pub fn print(text: String) {}\n";
+
+    struct ScratchFile {
+        std::string path = (std::filesystem::temp_directory_path() /
+                            ("xor-interface-test-" + std::to_string(getpid()) + ".xorh")).string();
+
+        ~ScratchFile() {
+            std::remove(path.c_str());
+        }
+    };
+
+    std::vector<ExportedSymbol> exports() {
+        Arena arena;
+        TokenBuffer tokens = lexAll(source);
+        Ast ast = parse(tokens, arena);
+        std::vector<ExportedSymbol> symbols;
+        collectExports(ast, symbols);
+        return symbols;
+    }
+}
+
+XOR_TEST(interfaceRoundTrip) {
+    ScratchFile scratch;
+    XOR_CHECK(writeInterface(scratch.path, "std", exports()));
+
+    std::optional<InterfaceFile> file = InterfaceFile::open(scratch.path);
+    XOR_CHECK(file.has_value());
+
+    if (!file.has_value())
+        return;
+
+    XOR_CHECK(file->library() == "std");
+    XOR_CHECK(file->symbolCount() == 6);
+    XOR_CHECK(file->find("hidden").second == 0);
+    XOR_CHECK(file->find("String::str").second == 0);
+    XOR_CHECK(file->find("missing").second == 0);
+
+    // Overloads come back together
+    XOR_CHECK(file->find("String::new").second == 2);
+
+    auto print = file->symbol(file->find("print").first);
+    XOR_CHECK(print.has_value() && print->kind == SymbolKind::FUNCTION && print->parameterCount == 1);
+
+    if (print.has_value()) {
+        auto text = file->parameter(*print, 0);
+        XOR_CHECK(text.has_value() && text->name == "text" && text->type == "String");
+        XOR_CHECK(!file->parameter(*print, 1).has_value());
+    }
+
+    auto conversion = file->symbol(file->find("String::cnv").first);
+    XOR_CHECK(conversion.has_value() && conversion->kind == SymbolKind::CONVERSION && conversion->type == "char[]");
+
+    auto plus = file->symbol(file->find("String::op+").first);
+    XOR_CHECK(plus.has_value() && plus->kind == SymbolKind::OPERATOR && plus->type == "String");
+}
+
+XOR_TEST(interfaceRejectsDamage) {
+    ScratchFile scratch;
+    XOR_CHECK(writeInterface(scratch.path, "std", exports()));
+    uintmax_t size = std::filesystem::file_size(scratch.path);
+
+    // Cut short, the file no longer has the size its header promises
+    std::filesystem::resize_file(scratch.path, size - 1);
+    XOR_CHECK(!InterfaceFile::open(scratch.path).has_value());
+
+    // Shorter than a header
+    std::filesystem::resize_file(scratch.path, 10);
+    XOR_CHECK(!InterfaceFile::open(scratch.path).has_value());
+
+    // Right size, wrong magic
+    XOR_CHECK(writeInterface(scratch.path, "std", exports()));
+    {
+        std::fstream file(scratch.path, std::ios::in | std::ios::out | std::ios::binary);
+        file.write("XORJUNK\n", 8);
+    }
+    XOR_CHECK(!InterfaceFile::open(scratch.path).has_value());
+
+    XOR_CHECK(!InterfaceFile::open(scratch.path + ".missing").has_value());
+}
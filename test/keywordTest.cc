@@ -0,0 +1,49 @@
+#include <string>
+#include "check.h"
+#include "../xor/lexer/keywords.h"
+
+// The perfect hash has to find every reserved word and nothing else, in
+// particular not a word that lands in a keyword's slot.
+
+namespace {
+    using namespace xorLang;
+}
+
+XOR_TEST(keywordsAreFound) {
+    for (const Keyword &keyword : keywords) {
+        std::optional<TokenType> type = lookupKeyword(keyword.spelling);
+        XOR_CHECK(type.has_value() && *type == keyword.type);
+    }
+
+    XOR_CHECK(lookupKeyword("ret") == TokenType::RETURN);
+    XOR_CHECK(lookupKeyword("fn") == TokenType::FN);
+    XOR_CHECK(lookupKeyword("i128") == TokenType::INT_128BIT);
+}
+
+XOR_TEST(nonKeywordsAreNot) {
+    for (std::string_view word : {"", "f", "fnn", "Fn", "FN", "returns", "_", "x", "print", "String"})
+        XOR_CHECK(!lookupKeyword(word).has_value());
+
+    // Longer than any keyword, so rejected before hashing
+    XOR_CHECK(!lookupKeyword(std::string(detail::keywordTable.maxLength + 1, 'a')).has_value());
+
+    // Words sharing a slot with a keyword have to fail the compare
+    size_t collisions = 0;
+
+    for (char a = 'a'; a <= 'z'; a++) {
+        for (char b = 'a'; b <= 'z'; b++) {
+            for (char c = 'a'; c <= 'z'; c++) {
+                std::string word = {a, b, c};
+                uint8_t slot = detail::keywordTable.slots[detail::keywordHash(word, detail::keywordTable.seed)];
+
+                if (slot == 0 || keywords[slot - 1].spelling == word)
+                    continue;
+
+                collisions++;
+                XOR_CHECK(!lookupKeyword(word).has_value());
+            }
+        }
+    }
+
+    XOR_CHECK(collisions > 0);
+}
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "check.h"
+#include "../xor/driver/tokenCache.h"
+#include "../xor/lexer/incremental.h"
+#include "../xor/lexer/parallelLexer.h"
+#include "../xor/lexer/streamLexer.h"
+#include "../xor/lexer/target.h"
+#include "../xor/lexer/tokenBuffer.h"
+
+// Every way of lexing a source has to agree with lexAll(): chunk-parallel
+// lexing for any chunk size, relex() after any sequence of edits, and the
+// StreamLexer however the input is split into reads.
+
+namespace {
+    using namespace xorLang;
+
+    // Pieces chosen so that token boundaries fall everywhere: doubled
+    // brackets, numbers next to dots, literals and comments that swallow what
+    // follows them, directives and the blocks they open.
+    const std::vector<std::string_view> pieces = {
+            " ", "  ", "\t", "\n", "x", "name", "fn", "(", "((", ")", "]", "[", "{", "}", ".", "..", ":", "::",
+            "=", "==", "-", "->", "+", "+=", "/", "//", "// comment\n", "\"str\"", "\"", "\\", "`", "'a'", "'",
+            "1", "1.5", "0x", "0xFF", "1e", "+3", "_", "#", "#[kill]", "#[if os == \"Linux\"]", "#[if false]",
+            "#[else]", "#[end if]", "#[asm]", "#[end asm]", "\xC3\xA9", "\x80", "$", "@"
+    };
+
+    bool sameTokens(const TokenBuffer &a, const TokenBuffer &b) {
+        if (a.size() != b.size())
+            return false;
+
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a.kind(i) != b.kind(i) || a.offset(i) != b.offset(i) || a.lengths[i] != b.lengths[i])
+                return false;
+
+            if (hasLiteral(a.kind(i)) && a.literal(i).low != b.literal(i).low)
+                return false;
+        }
+
+        return true;
+    }
+}
+
+XOR_TEST(parallelMatchesSerial) {
+    std::mt19937_64 random(3);
+    ThreadPool pool(4);
+
+    for (int round = 0; round < 1000; round++) {
+        std::string text = test::soup(random, pieces, random() % 400);
+        TokenBuffer serial = lexAll(text);
+
+        for (size_t chunkSize : {size_t{1}, size_t{7}, size_t{64}, 1 + random() % 200})
+            XOR_CHECK(sameTokens(lexParallel(text, pool, nullptr, chunkSize), serial));
+    }
+}
+
+XOR_TEST(relexMatchesFullLex) {
+    std::mt19937_64 random(5);
+
+    for (int round = 0; round < 2000; round++) {
+        std::string text = test::soup(random, pieces, random() % 300);
+        TokenBuffer buffer = lexAll(text);
+
+        for (int edit = 0; edit < 20; edit++) {
+            size_t offset = random() % (text.size() + 1);
+            size_t length = std::min<size_t>(random() % 16, text.size() - offset);
+            std::string replacement = test::soup(random, pieces, random() % 3);
+
+            relex(buffer, text, offset, length, replacement);
+
+            if (!sameTokens(buffer, lexAll(text))) {
+                XOR_CHECK(sameTokens(buffer, lexAll(text)));
+                break;
+            }
+
+            // Every literal slot is either used by a token or free again
+            size_t used = std::count_if(buffer.kinds.begin(), buffer.kinds.end(), [](uint8_t kind) {
+                return hasLiteral(static_cast<TokenType>(kind));
+            });
+
+            XOR_CHECK(buffer.literals.size() == used + buffer.freeLiterals.size());
+        }
+    }
+}
+
+XOR_TEST(streamMatchesLexAll) {
+    std::mt19937_64 random(9);
+
+    for (int round = 0; round < 300; round++) {
+        std::string text = test::soup(random, pieces, random() % 2000);
+
+        // Tokens far longer than the buffer, which arrive in many reads
+        if (round % 4 == 0) {
+            size_t at = random() % (text.size() + 1);
+            text.insert(at, round % 8 == 0 ? "\"" + std::string(5000, 's') + "\"" : "//" + std::string(5000, 'c') + "\n");
+        }
+
+        int fds[2];
+
+        if (pipe(fds) != 0) {
+            XOR_CHECK(false);
+            return;
+        }
+
+        // Writes in random small pieces, so tokens straddle reads
+        std::thread writer([&, seed = random()] {
+            std::mt19937_64 sizes(seed);
+
+            for (size_t at = 0; at < text.size();) {
+                size_t count = std::min<size_t>(1 + sizes() % 37, text.size() - at);
+                ssize_t written = write(fds[1], text.data() + at, count);
+
+                if (written <= 0)
+                    break;
+
+                at += static_cast<size_t>(written);
+            }
+
+            close(fds[1]);
+        });
+
+        TokenBuffer expected = lexAll(text);
+        StreamLexer lexer(fds[0], 16 + random() % 64);
+        bool same = true;
+
+        for (size_t i = 0; i < expected.size(); i++) {
+            size_t start = lexer.getIndex();
+            std::optional<Token> token = lexer.next();
+            TokenType kind = token.has_value() ? token->type : TokenType::INVALID;
+            size_t length = lexer.getIndex() - start;
+
+            if (token.has_value() && token->type == TokenType::EOI)
+                length = 0;
+
+            same &= kind == expected.kind(i) && start == expected.offset(i) && length == expected.lengths[i];
+        }
+
+        writer.join();
+        close(fds[0]);
+        XOR_CHECK(same);
+    }
+}
+
+XOR_TEST(streamCutsLongTokens) {
+    int fds[2];
+
+    if (pipe(fds) != 0) {
+        XOR_CHECK(false);
+        return;
+    }
+
+    std::string text = "x \"" + std::string(10000, 's') + "\" y";
+
+    std::thread writer([&] {
+        for (size_t at = 0; at < text.size();) {
+            ssize_t written = write(fds[1], text.data() + at, std::min<size_t>(100, text.size() - at));
+
+            if (written <= 0)
+                break;
+
+            at += static_cast<size_t>(written);
+        }
+
+        close(fds[1]);
+    });
+
+    StreamLexer lexer(fds[0], 64, nullptr, 1000);
+    size_t invalid = 0;
+    bool bounded = true;
+
+    while (true) {
+        size_t start = lexer.getIndex();
+        std::optional<Token> token = lexer.next();
+
+        if (token.has_value() && token->type == TokenType::EOI)
+            break;
+
+        if (!token.has_value()) {
+            invalid++;
+            bounded &= lexer.getIndex() - start <= 1000;
+        }
+    }
+
+    writer.join();
+    close(fds[0]);
+    XOR_CHECK(invalid >= 10);
+    XOR_CHECK(bounded);
+}
+
+XOR_TEST(cacheMapsEntries) {
+    std::mt19937_64 random(13);
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "xorCacheTest";
+    std::filesystem::remove_all(directory);
+    TokenCache cache(directory);
+    std::vector<std::string> texts;
+
+    for (int round = 0; round < 50; round++)
+        texts.push_back(test::soup(random, pieces, 1 + random() % 300));
+
+    for (const std::string &text : texts) {
+        TokenBuffer expected = lexAll(text);
+        XOR_CHECK(cache.store(expected));
+
+        std::optional<TokenBuffer> loaded = cache.load(text);
+        XOR_CHECK(loaded.has_value() && loaded->kinds.mapped() && sameTokens(*loaded, expected));
+
+        // The first change copies the mapped column
+        if (loaded.has_value()) {
+            std::string edited = text;
+            relex(*loaded, edited, 0, 0, "x ");
+            XOR_CHECK(!loaded->offsets.mapped() && sameTokens(*loaded, lexAll(edited)));
+        }
+    }
+
+    cache.prune(0);
+    XOR_CHECK(!cache.load(texts.front()).has_value());
+    std::filesystem::remove_all(directory);
+}
+
+XOR_TEST(ifDirectivesFollowTarget) {
+    auto kinds = [](const std::string &text) {
+        TokenBuffer tokens = lexAll(text);
+        std::vector<TokenType> result;
+
+        // Without the whitespace between them
+        for (size_t i = 0; i < tokens.size(); i++) {
+            if (tokens.kind(i) != TokenType::SPACE && tokens.kind(i) != TokenType::NEWLINE)
+                result.push_back(tokens.kind(i));
+        }
+
+        return result;
+    };
+
+    std::string os = currentTarget().os;
+    std::string body = "]\nfn a\n#[else]\nfn b\n#[end if]\n";
+
+    // A condition that holds opens its block and swallows the `#[else]` one
+    XOR_CHECK(kinds("#[if os == \"" + os + "\"" + body) == (std::vector<TokenType>{
+            TokenType::IF_DIRECTIVE, TokenType::FN, TokenType::IDENTIFIER, TokenType::INACTIVE_BLOCK,
+            TokenType::EOI
+    }));
+
+    // One that does not is skipped up to the `#[else]`
+    XOR_CHECK(kinds("#[if os != \"" + os + "\"" + body) == (std::vector<TokenType>{
+            TokenType::INACTIVE_BLOCK, TokenType::FN, TokenType::IDENTIFIER, TokenType::END_IF_DIRECTIVE,
+            TokenType::EOI
+    }));
+
+    XOR_CHECK(kinds("#[if os == \"NoSuchOS\"]\nfn a\n#[end if]") == (std::vector<TokenType>{
+            TokenType::INACTIVE_BLOCK, TokenType::EOI
+    }));
+}
+
+XOR_TEST(deepConditionsAreMalformed) {
+    Target target{"Linux", "x86_64"};
+
+    XOR_CHECK(evaluateCondition(std::string(1000000, '!') + "true", target) == true);
+    XOR_CHECK(evaluateCondition(std::string(200000, '(') + "true" + std::string(200000, ')'), target) == std::nullopt);
+    XOR_CHECK(evaluateCondition("!(os == \"Linux\") || ((arch == \"x86_64\"))", target) == true);
+}
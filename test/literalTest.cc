@@ -0,0 +1,131 @@
+#include <string>
+#include "check.h"
+#include "../xor/lexer/literal.h"
+
+// Literal values are decoded once, while lexing, so the decoder has to get
+// every base, width and rounding right on its own.
+
+namespace {
+    using namespace xorLang;
+
+    NumberScan scan(std::string_view text) {
+        NumberScan result = scanNumber(text, 0);
+
+        // A valid number is the whole text here
+        if (result.valid && result.end != text.length())
+            result.valid = false;
+
+        return result;
+    }
+
+    bool integer(std::string_view text, uint64_t low, uint64_t high = 0, bool overflow = false) {
+        NumberScan result = scan(text);
+
+        return result.valid && result.kind == TokenType::NUMBER && result.literal.low == low &&
+               result.literal.high == high && result.literal.overflow == overflow;
+    }
+}
+
+XOR_TEST(integerLiteralsDecode) {
+    XOR_CHECK(integer("0", 0));
+    XOR_CHECK(integer("1_000_000", 1000000));
+    XOR_CHECK(integer("12345678901234567890", 12345678901234567890u));
+    XOR_CHECK(integer("0xFF_FF", 0xFFFF));
+    XOR_CHECK(integer("0Xdeadbeef", 0xDEADBEEF));
+    XOR_CHECK(integer("0b1010", 10));
+    XOR_CHECK(integer("0x1_0000_0000_0000_0000", 0, 1));
+
+    // 2^128 - 1 is the largest magnitude there is
+    XOR_CHECK(integer("340282366920938463463374607431768211455", ~uint64_t{0}, ~uint64_t{0}));
+    XOR_CHECK(scan("340282366920938463463374607431768211456").literal.overflow);
+    XOR_CHECK(integer(std::string(32, 'F').insert(0, "0x"), ~uint64_t{0}, ~uint64_t{0}));
+    XOR_CHECK(scan(std::string(33, 'F').insert(0, "0x")).literal.overflow);
+    XOR_CHECK(scan("0b" + std::string(129, '1')).literal.overflow);
+
+    XOR_CHECK(!scan("0x").valid);
+    XOR_CHECK(!scan("0b2").valid);
+
+    // A `_` goes between two digits and nowhere else
+    XOR_CHECK(integer("0b1_0", 2));
+    XOR_CHECK(!scan("1_").valid);
+    XOR_CHECK(!scan("1__0").valid);
+    XOR_CHECK(!scan("0x_FF").valid);
+    XOR_CHECK(!scan("0xFF_").valid);
+    XOR_CHECK(!scan("1_u8").valid);
+    XOR_CHECK(!scan("1.5_").valid);
+    XOR_CHECK(!scan("1e5_").valid);
+    XOR_CHECK(scanNumber("1._5", 0).end == 1);
+}
+
+XOR_TEST(suffixesLimitIntegers) {
+    // A signed suffix takes the magnitude of its minimum, negated by a unary `-`
+    XOR_CHECK(integer("127i8", 127));
+    XOR_CHECK(integer("128i8", 128));
+    XOR_CHECK(integer("129i8", 129, 0, true));
+    XOR_CHECK(integer("255u8", 255));
+    XOR_CHECK(integer("256u8", 256, 0, true));
+    XOR_CHECK(integer("65535u16", 65535));
+    XOR_CHECK(integer("0xFFFF_FFFFu32", 0xFFFFFFFF));
+    XOR_CHECK(integer("0x1_0000_0000u32", 0x100000000, 0, true));
+    XOR_CHECK(integer("9223372036854775808i64", 9223372036854775808u));
+    XOR_CHECK(integer("9223372036854775809i64", 9223372036854775809u, 0, true));
+    XOR_CHECK(scan("255u8").literal.type == TokenType::UINT_8BIT);
+
+    XOR_CHECK(!scan("1u7").valid);
+    XOR_CHECK(!scan("1.5u8").valid);
+    XOR_CHECK(!scan("0b1f32").valid);
+}
+
+XOR_TEST(floatLiteralsRound) {
+    NumberScan single = scan("0.1f32");
+    NumberScan wide = scan("0.1");
+    NumberScan suffixed = scan("3f64");
+
+    XOR_CHECK(single.valid && single.kind == TokenType::DECIMAL_NUMBER && single.literal.type == TokenType::FLOAT_32BIT);
+    XOR_CHECK(single.literal.real == static_cast<double>(0.1f));
+    XOR_CHECK(wide.valid && wide.literal.type == TokenType::FLOAT_MAXBIT && wide.literal.real == 0.1);
+    XOR_CHECK(suffixed.valid && suffixed.kind == TokenType::DECIMAL_NUMBER && suffixed.literal.real == 3.0);
+    XOR_CHECK(scan("6.02e+23").literal.real == 6.02e23);
+    XOR_CHECK(scan("1_000.000_5").literal.real == 1000.0005);
+    XOR_CHECK(scan("1e39f32").literal.overflow);
+    XOR_CHECK(!scan("1e39").literal.overflow);
+    XOR_CHECK(scan("1e309").literal.overflow);
+
+    // An exponent needs digits
+    XOR_CHECK(!scan("1e").valid);
+    XOR_CHECK(!scan("1e+").valid);
+    XOR_CHECK(!scan("1e_5").valid);
+    XOR_CHECK(!scan("1.5ex").valid);
+
+    // A dot without a digit after it is not part of the number
+    XOR_CHECK(scanNumber("1..2", 0).end == 1);
+    XOR_CHECK(scanNumber("1.abs", 0).end == 1);
+}
+
+XOR_TEST(charLiteralsDecode) {
+    XOR_CHECK(decodeChar("a") == 'a');
+    XOR_CHECK(decodeChar("\\n") == '\n');
+    XOR_CHECK(decodeChar("\\'") == '\'');
+    XOR_CHECK(decodeChar("\xC3\xA9") == 0xE9);
+    XOR_CHECK(decodeChar("\xE2\x82\xAC") == 0x20AC);
+    XOR_CHECK(decodeChar("\xF0\x9F\x98\x80") == 0x1F600);
+
+    XOR_CHECK(decodeChar("") == std::nullopt);
+    XOR_CHECK(decodeChar("ab") == std::nullopt);
+    XOR_CHECK(decodeChar("\\q") == std::nullopt);
+    XOR_CHECK(decodeChar("\xC3") == std::nullopt);
+    XOR_CHECK(decodeChar("\x80") == std::nullopt);
+
+    // Only well-formed UTF-8: no lead bytes past F4, no code points past
+    // U+10FFFF, no overlong forms and no surrogates
+    XOR_CHECK(decodeChar("\xF4\x8F\xBF\xBF") == 0x10FFFF);
+    XOR_CHECK(decodeChar("\xF4\x90\x80\x80") == std::nullopt);
+    XOR_CHECK(decodeChar("\xF5\x80\x80\x80") == std::nullopt);
+    XOR_CHECK(decodeChar("\xF8\x80\x80") == std::nullopt);
+    XOR_CHECK(decodeChar("\xFF\x80\x80") == std::nullopt);
+    XOR_CHECK(decodeChar("\xC0\x80") == std::nullopt);
+    XOR_CHECK(decodeChar("\xE0\x80\xAF") == std::nullopt);
+    XOR_CHECK(decodeChar("\xF0\x80\x80\xAF") == std::nullopt);
+    XOR_CHECK(decodeChar("\xED\xA0\x80") == std::nullopt);
+    XOR_CHECK(decodeChar("\xED\x9F\xBF") == 0xD7FF);
+}
@@ -0,0 +1,33 @@
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#include "check.h"
+
+// Runs the equivalence and fuzz checks of test/*.cc, or only those whose
+// name contains the first argument:
+//
+//   test [filter]
+//
+// `make test TEST_FLAGS=-fsanitize=thread` runs them under TSan.
+
+int main(int argc, char **argv) {
+    std::string_view filter = argc > 1 ? argv[1] : "";
+    size_t ran = 0;
+
+    for (const xorLang::test::Case &test : xorLang::test::cases()) {
+        if (std::string_view(test.name).find(filter) == std::string_view::npos)
+            continue;
+
+        size_t before = xorLang::test::failures;
+        auto start = std::chrono::steady_clock::now();
+        test.run();
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        std::printf("%-32s %s (%.2fs)\n", test.name, xorLang::test::failures == before ? "ok" : "FAILED",
+                    seconds.count());
+        ran++;
+    }
+
+    std::printf("%zu tests, %zu failed checks\n", ran, xorLang::test::failures);
+    return xorLang::test::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include "check.h"
+#include "../bench/corpus.h"
+#include "../xor/parser/parser.h"
+#include "../xor/parser/pipeline.h"
+#include "../xor/util/spscRing.h"
+
+// The token ring and the pipelined parse are only worth anything if they
+// hand over exactly what a serial lex and parse produce. Run these under
+// TSan as well: `make test TEST_FLAGS=-fsanitize=thread`.
+
+namespace {
+    using namespace xorLang;
+
+    bool sameAst(const Ast &a, const Ast &b) {
+        if (a.nodes.size() != b.nodes.size() || a.extra.size() != b.extra.size() ||
+            a.errors.size() != b.errors.size())
+            return false;
+
+        for (uint32_t i = 0; i < a.nodes.size(); i++) {
+            const Node &x = a.nodes[i];
+            const Node &y = b.nodes[i];
+
+            if (x.kind != y.kind || x.modifiers != y.modifiers || x.token != y.token || x.a != y.a || x.b != y.b)
+                return false;
+        }
+
+        for (uint32_t i = 0; i < a.errors.size(); i++)
+            if (a.errors[i].token != b.errors[i].token || a.errors[i].message != b.errors[i].message)
+                return false;
+
+        return std::memcmp(a.extra.begin(), b.extra.begin(), a.extra.size() * sizeof(uint32_t)) == 0;
+    }
+}
+
+XOR_TEST(ringKeepsOrder) {
+    for (size_t capacity : {size_t{1}, size_t{2}, size_t{64}}) {
+        SpscRing<uint64_t> ring(capacity);
+        constexpr uint64_t count = 200000;
+
+        std::thread producer([&] {
+            for (uint64_t i = 0; i < count; i++)
+                ring.push(i);
+        });
+
+        bool ordered = true;
+
+        for (uint64_t i = 0; i < count; i++)
+            ordered &= ring.pop() == i;
+
+        producer.join();
+
+        uint64_t left;
+        XOR_CHECK(ordered);
+        XOR_CHECK(!ring.tryPop(left));
+    }
+}
+
+XOR_TEST(pipelinedMatchesSerialParse) {
+    for (bench::Mix mix : {bench::Mix::MIXED, bench::Mix::NESTING, bench::Mix::STRING, bench::Mix::PLATFORM}) {
+        for (uint64_t seed = 1; seed <= 3; seed++) {
+            std::string source = bench::CorpusGenerator(seed).generate(mix, 200000);
+
+            // Some damage, so error recovery gets compared too
+            std::mt19937_64 random(seed);
+
+            for (int i = 0; i < 20; i++)
+                source[random() % source.size()] = "{}();#\""[random() % 7];
+
+            Arena serialArena;
+            Arena pipedArena;
+            TokenBuffer serialTokens = lexAll(source);
+            TokenBuffer pipedTokens;
+            Ast serial = parse(serialTokens, serialArena);
+            Ast piped = parsePipelined(source, pipedTokens, pipedArena);
+
+            XOR_CHECK(pipedTokens.kinds == serialTokens.kinds && pipedTokens.offsets == serialTokens.offsets);
+            XOR_CHECK(sameAst(serial, piped));
+        }
+    }
+}
+
+XOR_TEST(deepNestingIsAnError) {
+    auto repeat = [](std::string_view piece, size_t count) {
+        std::string text;
+
+        for (size_t i = 0; i < count; i++)
+            text += piece;
+
+        return text;
+    };
+
+    constexpr size_t depth = 200000;
+    const std::string deep[] = {
+            "fn f() { x = " + repeat("(", depth) + "1" + repeat(")", depth) + "; }",
+            "fn f() { x = " + repeat("-", depth) + "1; }",
+            "fn f() " + repeat("{", depth) + repeat("}", depth),
+            "fn f() -> " + repeat("&", depth) + "T;",
+            repeat("class A { ", depth) + repeat("}", depth)
+    };
+
+    for (const std::string &source : deep) {
+        Arena arena;
+        TokenBuffer tokens = lexAll(source);
+        Ast ast = parse(tokens, arena);
+        bool reported = false;
+
+        for (uint32_t i = 0; i < ast.errors.size(); i++)
+            reported |= ast.errors[i].message == "nested too deeply";
+
+        XOR_CHECK(reported);
+        XOR_CHECK(ast.errors.size() <= 3);
+    }
+
+    // A long `else if` chain is not nesting
+    Arena arena;
+    std::string chain = "fn f() { if a {}" + repeat(" else if a {}", depth) + " else {} }";
+    TokenBuffer tokens = lexAll(chain);
+    Ast ast = parse(tokens, arena);
+
+    XOR_CHECK(ast.errors.size() == 0);
+}
+
+XOR_TEST(unreservedWordsAreNames) {
+    // `in` and `as` only mean something after a loop variable and an import
+    const std::string valid[] = {
+            "import std::io as io;\nfn f(from: i8, int: i8, type: float) { for in in as { delete(in); } }",
+            "fn f() { mut asm = prot; cxx = expose + uint; }",
+    };
+
+    for (const std::string &source : valid) {
+        Arena arena;
+        TokenBuffer tokens = lexAll(source);
+        Ast ast = parse(tokens, arena);
+        XOR_CHECK(ast.errors.size() == 0);
+    }
+
+    Arena arena;
+    TokenBuffer tokens = lexAll("fn f() { for x of xs {} }");
+    XOR_CHECK(parse(tokens, arena).errors.size() != 0);
+}
+
+XOR_TEST(brokenMembersKeepTheirClass) {
+    // Recovery must not take the `}` that closes the class
+    for (std::string source : {"class A { pub } fn f() {}", "class A { op } fn f() {}", "class A { pub op } fn f() {}"}) {
+        Arena arena;
+        TokenBuffer tokens = lexAll(source);
+        Ast ast = parse(tokens, arena);
+        const Node &file = ast.node(0);
+
+        XOR_CHECK(ast.errors.size() == 1);
+        XOR_CHECK(ast.listSize(file.a) == 2);
+
+        if (ast.listSize(file.a) == 2) {
+            XOR_CHECK(ast.node(ast.listItem(file.a, 0)).kind == NodeKind::CLASS);
+            XOR_CHECK(ast.node(ast.listItem(file.a, 1)).kind == NodeKind::FUNCTION);
+        }
+    }
+
+    // A stray `}` at file level is still skipped, leaving an error node
+    Arena arena;
+    TokenBuffer tokens = lexAll("} fn f() {}");
+    Ast ast = parse(tokens, arena);
+    const Node &file = ast.node(0);
+
+    XOR_CHECK(ast.errors.size() == 1 && ast.listSize(file.a) == 2);
+    XOR_CHECK(ast.node(ast.listItem(file.a, ast.listSize(file.a) - 1)).kind == NodeKind::FUNCTION);
+}
@@ -0,0 +1,134 @@
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "../xor/lexer/scan.h"
+#include "../xor/lexer/utf8.h"
+
+// Every vector kernel has to return the same offsets as the scalar one, on
+// buffers dense in the bytes that end a run and at every alignment.
+
+namespace {
+    using namespace xorLang;
+
+    std::vector<detail::ScanKernels> vectorKernels() {
+        std::vector<detail::ScanKernels> kernels;
+
+        for (ScanIsa isa : {ScanIsa::SSE2, ScanIsa::AVX2, ScanIsa::AVX512})
+            if (std::optional<detail::ScanKernels> found = detail::scanKernelsFor(isa))
+                kernels.push_back(*found);
+
+        return kernels;
+    }
+
+    std::string randomBytes(std::mt19937_64 &random, size_t length) {
+        static constexpr std::string_view alphabet = "aZ_09 \t\n\"`\\#[]x";
+        std::string text(length, ' ');
+
+        for (char &c : text) {
+            uint64_t pick = random() % 20;
+            c = pick < alphabet.length() ? alphabet[pick] : static_cast<char>(0x80 + random() % 0x80);
+        }
+
+        return text;
+    }
+
+    // Valid code points of every length, with some of them broken afterwards:
+    // truncated, overlong, surrogates, past U+10FFFF, stray continuations.
+    std::string randomUtf8(std::mt19937_64 &random, size_t count) {
+        std::string text;
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t length = 1 + random() % 4;
+            uint32_t code = length == 1 ? random() % 0x80
+                          : length == 2 ? 0x80 + random() % 0x780
+                          : length == 3 ? 0x800 + random() % 0xF800
+                                        : 0x10000 + random() % 0x100000;
+
+            if (length == 3 && code >= 0xD800 && code <= 0xDFFF && random() % 4 != 0)
+                code = 0xE000;
+
+            if (length == 1) {
+                text += static_cast<char>(code);
+            } else if (length == 2) {
+                text += static_cast<char>(0xC0 | (code >> 6));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (length == 3) {
+                text += static_cast<char>(0xE0 | (code >> 12));
+                text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                text += static_cast<char>(0xF0 | (code >> 18));
+                text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        for (size_t i = 0, breaks = random() % 3; i < breaks && !text.empty(); i++) {
+            static constexpr uint8_t bad[] = {0x80, 0xBF, 0xC0, 0xC1, 0xE0, 0xED, 0xF0, 0xF4, 0xF5, 0xFF};
+            size_t at = random() % text.size();
+
+            if (random() % 2 == 0)
+                text[at] = static_cast<char>(bad[random() % std::size(bad)]);
+            else
+                text.erase(at, 1);
+        }
+
+        return text;
+    }
+}
+
+XOR_TEST(scanKernelsMatchScalar) {
+    std::mt19937_64 random(7);
+    detail::ScanKernels scalar = *detail::scanKernelsFor(ScanIsa::SCALAR);
+
+    for (const detail::ScanKernels &kernels : vectorKernels()) {
+        for (int round = 0; round < 4000; round++) {
+            std::string text = randomBytes(random, random() % 300);
+            const char *data = text.data();
+            size_t size = text.size();
+
+            for (size_t from = 0; from <= size; from += 1 + random() % 8) {
+                XOR_CHECK(kernels.identifier(data, size, from) == scalar.identifier(data, size, from));
+                XOR_CHECK(kernels.line(data, size, from) == scalar.line(data, size, from));
+
+                for (char c : {' ', '\t', '#', 'a'}) {
+                    XOR_CHECK(kernels.run(data, size, from, c) == scalar.run(data, size, from, c));
+                    XOR_CHECK(kernels.find(data, size, from, c) == scalar.find(data, size, from, c));
+                }
+
+                for (char quote : {'"', '`'})
+                    XOR_CHECK(kernels.quoted(data, size, from, quote) == scalar.quoted(data, size, from, quote));
+            }
+        }
+    }
+}
+
+XOR_TEST(utf8KernelsMatchScalar) {
+    std::mt19937_64 random(11);
+
+    for (int round = 0; round < 20000; round++) {
+        std::string text = randomUtf8(random, random() % 200);
+        const auto *data = reinterpret_cast<const uint8_t *>(text.data());
+        size_t size = text.size();
+
+        // Decoding may only start at the start of a sequence
+        for (size_t from = 0; from <= size; from += 1 + random() % 64) {
+            while (from < size && detail::utf8::isContinuation(data[from]))
+                from++;
+
+            size_t expected = detail::utf8::scalarFind(data, size, from);
+
+#if defined(XOR_SCAN_X86)
+            XOR_CHECK(detail::utf8::sse2Find(data, size, from) == expected);
+
+            if (__builtin_cpu_supports("avx2"))
+                XOR_CHECK(detail::utf8::avx2::find(data, size, from) == expected);
+#endif
+
+            XOR_CHECK(findInvalidUtf8(text, from) == expected);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "../xor/lexer/tokenBuffer.h"
+#include "../xor/util/symbolTable.h"
+
+// Equal names have to get equal IDs however many threads intern them at
+// once, and an ID has to lead back to its spelling.
+
+namespace {
+    using namespace xorLang;
+}
+
+XOR_TEST(symbolsAreStable) {
+    SymbolTable symbols;
+    // Prime, so every stride below visits all names
+    constexpr size_t names = 4999;
+    std::vector<std::vector<SymbolId>> ids(4, std::vector<SymbolId>(names));
+    std::vector<std::thread> threads;
+
+    // Every thread interns the same names, each in its own order
+    for (size_t t = 0; t < ids.size(); t++) {
+        threads.emplace_back([&, t] {
+            for (size_t i = 0; i < names; i++) {
+                size_t name = (i * (2 * t + 1)) % names;
+                ids[t][name] = symbols.intern("name" + std::to_string(name));
+            }
+        });
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    bool same = true;
+    bool named = true;
+
+    for (size_t i = 0; i < names; i++) {
+        for (size_t t = 1; t < ids.size(); t++)
+            same &= ids[t][i] == ids[0][i];
+
+        named &= ids[0][i] != 0 && symbols.name(ids[0][i]) == "name" + std::to_string(i);
+    }
+
+    XOR_CHECK(same);
+    XOR_CHECK(named);
+    XOR_CHECK(symbols.size() == names);
+}
+
+XOR_TEST(lexerInternsIdentifiers) {
+    SymbolTable symbols;
+    std::string source = "fn alpha(beta) { alpha = beta + gamma; }";
+    TokenBuffer buffer = lexAll(source, &symbols);
+    size_t identifiers = 0;
+
+    for (size_t i = 0; i < buffer.size(); i++) {
+        if (buffer.kind(i) != TokenType::IDENTIFIER)
+            continue;
+
+        identifiers++;
+        XOR_CHECK(buffer.payloads[i] == symbols.intern(buffer.value(i)));
+    }
+
+    XOR_CHECK(identifiers == 5);
+    XOR_CHECK(symbols.size() == 3);
+}
@@ -0,0 +1,634 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "buildState.h"
+#include "project.h"
+
+namespace xorLang {
+    // What to build. Files import each other as `name::dir::file::symbol`,
+    // the module path being the file's path below `sourcesPath`, or as
+    // `import "file.xor"` relative to the importing file; any other first
+    // segment names a library.
+    struct BuildPlan {
+        std::vector<SourceEntry> sources;
+        std::filesystem::path sourcesPath;
+        std::string name;
+        // Library interfaces to read, see InterfaceSet
+        std::vector<std::string> interfaces;
+        // Interface to write for the project, none when empty
+        std::string header;
+        // Where the build state lives, none when empty, which makes every
+        // build a full one
+        std::string state;
+    };
+
+    struct BuildReport {
+        // Files parsed or checked by this build, in path order
+        std::vector<FileResult> files;
+        size_t upToDate = 0;
+        // Imports resolved across the whole project, up to date files included
+        size_t resolved = 0;
+        // Symbols written to `header`, nullopt when it was up to date
+        std::optional<size_t> exported;
+        bool headerFailed = false;
+        // The interface that could not be read, when one could not
+        std::string badInterface;
+    };
+
+    namespace detail::build {
+        // What an import refers to: a project file, a library, or nothing.
+        struct Target {
+            enum Kind : uint8_t {
+                FILE, LIBRARY, MISSING
+            };
+
+            Kind kind = MISSING;
+            size_t file = 0;
+            std::string library;
+            std::string symbol;
+        };
+
+        // A source file and the inputs to checking it, from this build's parse
+        // or, when its source is unchanged, from the last build's record.
+        struct Unit {
+            std::string path;
+            Fingerprint fingerprint;
+            FileRecord *record = nullptr;
+            FileResult *result = nullptr;
+            const std::vector<ImportPath> *imports = nullptr;
+            // Null for a recorded file until exportsOf() decodes them
+            const std::vector<ExportedSymbol> *exports = nullptr;
+            uint64_t exportsHash = 0;
+            std::string encoded;
+            std::vector<ExportedSymbol> decoded;
+            std::vector<Target> targets;
+            std::vector<Dependency> dependencies;
+            // Units waiting for this one to be checked
+            std::vector<size_t> dependents;
+            bool check = false;
+            size_t resolved = 0;
+        };
+
+        inline std::vector<std::string_view> split(std::string_view path) {
+            std::vector<std::string_view> segments;
+
+            for (size_t at = 0;;) {
+                size_t end = path.find("::", at);
+                segments.push_back(path.substr(at, end - at));
+
+                if (end == std::string_view::npos)
+                    return segments;
+
+                at = end + 2;
+            }
+        }
+
+        inline std::string join(const std::vector<std::string_view> &segments, size_t from, size_t to) {
+            std::string text;
+
+            for (size_t i = from; i < to; i++) {
+                if (i > from)
+                    text += "::";
+
+                text += segments[i];
+            }
+
+            return text;
+        }
+
+        // Whether `exports`, sorted by name, has what `import ...::symbol`
+        // asks for; see InterfaceFile::contains().
+        inline bool contains(const std::vector<ExportedSymbol> &exports, std::string_view symbol) {
+            if (symbol.empty() || symbol == "*")
+                return true;
+
+            if (symbol.ends_with("::*"))
+                symbol.remove_suffix(3);
+
+            auto it = std::lower_bound(exports.begin(), exports.end(), symbol,
+                                       [](const ExportedSymbol &a, std::string_view name) { return a.name < name; });
+            return it != exports.end() && it->name == symbol;
+        }
+    }
+
+    // Builds a project incrementally. A file is parsed again only when its
+    // source changed since the last build, and checked again when it was
+    // parsed or when what it imports changed: the exports of a project file
+    // or the interface of a library. Parsing needs nothing from other files,
+    // so every changed file is parsed at once, largest first. Checking a file
+    // needs the exports of the files it imports, so checks follow the import
+    // graph in topological order, each submitted to the pool as soon as the
+    // files it imports are checked. Files in an import cycle are checked
+    // last, together.
+    //
+    // Up to date files cost a stat() each, so a build with nothing to do
+    // takes about as long as loading the state. Files with errors are never
+    // recorded and always build again.
+    class Build {
+        using Target = detail::build::Target;
+        using Unit = detail::build::Unit;
+
+        const BuildPlan &plan;
+        ThreadPool &pool;
+        SymbolTable &symbols;
+        Profiler &profiler;
+        const BuildSettings &settings;
+
+        BuildState state;
+        InterfaceSet interfaces;
+        // Interface hash by library name
+        std::unordered_map<std::string, uint64_t> libraries;
+        std::vector<Unit> units;
+        std::unordered_map<std::string_view, size_t> byName;
+        // Normalized paths and module paths, only built when some import has
+        // to be resolved again
+        std::unordered_map<std::string, size_t> byPath;
+        std::unordered_map<std::string, size_t> byModule;
+        uint64_t layout = 0;
+        std::vector<FileResult> parsed;
+        std::vector<FileResult> checked;
+        bool changed = false;
+
+        bool loadInterfaces(BuildReport &report) {
+            std::unordered_map<std::string, Fingerprint> fingerprints;
+
+            for (const std::string &path : plan.interfaces) {
+                const InterfaceFile *file = interfaces.add(path);
+                std::optional<Fingerprint> fingerprint = statFile(path);
+
+                if (file == nullptr || !fingerprint.has_value()) {
+                    report.badInterface = path;
+                    return false;
+                }
+
+                auto last = state.libraries.find(path);
+
+                if (last != state.libraries.end() && state.unchanged(last->second, *fingerprint))
+                    fingerprint->hash = last->second.hash;
+                else
+                    fingerprint->hash = hashFile(path).value_or(0);
+
+                libraries[std::string(file->library())] = fingerprint->hash;
+                fingerprints[path] = *fingerprint;
+            }
+
+            changed |= fingerprints.size() != state.libraries.size() ||
+                       !std::all_of(fingerprints.begin(), fingerprints.end(), [&](const auto &entry) {
+                           auto last = state.libraries.find(entry.first);
+                           return last != state.libraries.end() && last->second.sameStat(entry.second) &&
+                                  last->second.hash == entry.second.hash;
+                       });
+
+            state.libraries = std::move(fingerprints);
+            return true;
+        }
+
+        // Finds the files whose sources changed and parses them.
+        void parseChanged() {
+            std::vector<SourceEntry> changedSources;
+            std::vector<size_t> changedUnits;
+            units.resize(plan.sources.size());
+
+            {
+                auto scope = profiler.phase("stat");
+
+                for (size_t i = 0; i < plan.sources.size(); i++) {
+                    Unit &unit = units[i];
+                    unit.path = plan.sources[i].path.string();
+
+                    std::optional<Fingerprint> fingerprint = statFile(unit.path);
+                    auto last = state.files.find(unit.path);
+
+                    if (fingerprint.has_value() && last != state.files.end()) {
+                        const Fingerprint &recorded = last->second.fingerprint;
+
+                        bool same = state.unchanged(recorded, *fingerprint);
+
+                        // Touched but not changed, e.g. by a checkout, or too
+                        // recent to tell from the stat alone
+                        if (!same && recorded.size == fingerprint->size && hashFile(unit.path) == recorded.hash) {
+                            last->second.fingerprint = Fingerprint{fingerprint->size, fingerprint->modified,
+                                                                   recorded.hash};
+                            changed = true;
+                            same = true;
+                        }
+
+                        if (same) {
+                            unit.fingerprint = recorded;
+                            unit.record = &last->second;
+                            unit.imports = &unit.record->imports;
+                            unit.exportsHash = unit.record->exportsHash;
+                            continue;
+                        }
+                    }
+
+                    unit.fingerprint = fingerprint.value_or(Fingerprint{});
+                    changedSources.push_back(plan.sources[i]);
+                    changedUnits.push_back(i);
+                }
+            }
+
+            parsed = lexSources(changedSources, pool, symbols, profiler, settings);
+
+            for (size_t i = 0; i < changedUnits.size(); i++) {
+                Unit &unit = units[changedUnits[i]];
+                FileResult &result = parsed[i];
+
+                unit.result = &result;
+                unit.imports = &result.imports;
+                unit.exports = &result.exports;
+                unit.encoded = encodeExports(result.exports);
+                unit.exportsHash = hashBytes(unit.encoded);
+                unit.fingerprint.hash = result.hash;
+                unit.check = true;
+            }
+        }
+
+        // The exports of `unit`, decoding recorded ones on first use.
+        const std::vector<ExportedSymbol> &exportsOf(Unit &unit) {
+            if (unit.exports == nullptr) {
+                unit.decoded = decodeExports(unit.record->exports).value_or(std::vector<ExportedSymbol>{});
+                unit.exports = &unit.decoded;
+            }
+
+            return *unit.exports;
+        }
+
+        void indexModules() {
+            for (size_t i = 0; i < units.size(); i++) {
+                byPath[std::filesystem::path(units[i].path).lexically_normal().string()] = i;
+
+                std::filesystem::path module = plan.sources[i].path.lexically_relative(plan.sourcesPath);
+                std::string name = module.replace_extension().generic_string();
+
+                for (size_t at = name.find('/'); at != std::string::npos; at = name.find('/', at + 2))
+                    name.replace(at, 1, "::");
+
+                byModule[name] = i;
+            }
+        }
+
+        // Whether the files and libraries `unit` was checked against are
+        // unchanged. Only holds up while no file was added, removed or moved,
+        // otherwise its imports could resolve to other files now.
+        [[nodiscard]] bool dependenciesUnchanged(const Unit &unit) const {
+            for (const Dependency &dependency : unit.record->dependencies) {
+                uint64_t version = 0;
+
+                if (dependency.library) {
+                    auto library = libraries.find(dependency.name);
+                    version = library != libraries.end() ? library->second : 0;
+                } else {
+                    auto file = byName.find(dependency.name);
+
+                    if (file == byName.end())
+                        return false;
+
+                    version = units[file->second].exportsHash;
+                }
+
+                if (version != dependency.version)
+                    return false;
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] Target target(const Unit &unit, const ImportPath &import) const {
+            using namespace detail::build;
+
+            Target target;
+
+            if (import.quoted) {
+                std::filesystem::path file = std::filesystem::path(unit.path).parent_path() / import.path;
+                auto it = byPath.find(file.lexically_normal().string());
+
+                if (it != byPath.end()) {
+                    target.kind = Target::FILE;
+                    target.file = it->second;
+                }
+
+                return target;
+            }
+
+            std::vector<std::string_view> segments = split(import.path);
+
+            if (segments[0] != plan.name || plan.name.empty()) {
+                target.kind = Target::LIBRARY;
+                target.library = segments[0];
+                target.symbol = join(segments, 1, segments.size());
+                return target;
+            }
+
+            // The longest prefix naming a file is the module, the rest a symbol in it
+            for (size_t end = segments.size(); end > 1; end--) {
+                auto it = byModule.find(join(segments, 1, end));
+
+                if (it != byModule.end()) {
+                    target.kind = Target::FILE;
+                    target.file = it->second;
+                    target.symbol = join(segments, end, segments.size());
+                    break;
+                }
+            }
+
+            return target;
+        }
+
+        // Decides which files to check: the parsed ones and those whose
+        // dependencies are not what they were checked against, and resolves
+        // the imports of those to targets.
+        void linkImports() {
+            auto scope = profiler.phase("graph");
+
+            layout = hashBytes(plan.sourcesPath.string(), hashBytes(plan.name));
+
+            for (size_t i = 0; i < units.size(); i++) {
+                byName[units[i].path] = i;
+                layout = hashBytes(units[i].path, layout);
+            }
+
+            bool moved = layout != state.layout;
+
+            for (Unit &unit : units) {
+                if (unit.imports == nullptr || (!unit.check && !moved && dependenciesUnchanged(unit)))
+                    continue;
+
+                if (byModule.empty())
+                    indexModules();
+
+                for (const ImportPath &import : *unit.imports) {
+                    Target target = this->target(unit, import);
+
+                    if (target.kind == Target::FILE) {
+                        unit.dependencies.push_back(Dependency{units[target.file].path, false,
+                                                               units[target.file].exportsHash});
+                    } else if (target.kind == Target::LIBRARY) {
+                        auto library = libraries.find(target.library);
+                        uint64_t version = library != libraries.end() ? library->second : 0;
+                        unit.dependencies.push_back(Dependency{target.library, true, version});
+                    }
+
+                    unit.targets.push_back(std::move(target));
+                }
+
+                std::sort(unit.dependencies.begin(), unit.dependencies.end(), [](const auto &a, const auto &b) {
+                    return a.library != b.library ? a.library < b.library : a.name < b.name;
+                });
+                unit.dependencies.erase(std::unique(unit.dependencies.begin(), unit.dependencies.end()),
+                                        unit.dependencies.end());
+
+                if (unit.record != nullptr && unit.record->dependencies != unit.dependencies)
+                    unit.check = true;
+            }
+        }
+
+        void check(size_t index) {
+            Unit &unit = units[index];
+            auto scope = profiler.phase("check", unit.path);
+            std::optional<SourceFile> file;
+            std::optional<LineIndex> lines;
+
+            // Only unresolved imports need a position, and they are rare
+            auto locate = [&](size_t offset) {
+                if (!lines.has_value()) {
+                    file = SourceFile::open(unit.path);
+                    lines.emplace(file.has_value() ? file->view() : std::string_view());
+                }
+
+                return lines->position(offset);
+            };
+
+            for (size_t i = 0; i < unit.targets.size(); i++) {
+                const Target &target = unit.targets[i];
+                const ImportPath &import = (*unit.imports)[i];
+                bool found;
+
+                if (target.kind == Target::FILE) {
+                    found = detail::build::contains(*units[target.file].exports, target.symbol);
+                } else if (target.kind == Target::LIBRARY) {
+                    const InterfaceFile *library = interfaces.find(target.library);
+
+                    // Not a library we were given, nothing to check it against
+                    if (library == nullptr)
+                        continue;
+
+                    found = library->contains(target.symbol);
+                } else {
+                    found = false;
+                }
+
+                if (found)
+                    unit.resolved++;
+                else
+                    unit.result->errors.report(LexErrorKind::UNRESOLVED_IMPORT, import.offset, import.length, locate);
+            }
+        }
+
+        // Checks the units marked for it in topological order of their imports.
+        void checkAll() {
+            size_t count = 0;
+
+            for (Unit &unit : units)
+                count += unit.check && unit.result == nullptr;
+
+            checked.resize(count);
+            count = 0;
+
+            for (Unit &unit : units) {
+                if (!unit.check || unit.result != nullptr)
+                    continue;
+
+                FileResult &result = checked[count++];
+                result.path = unit.path;
+                result.opened = true;
+                result.errors = ErrorLog(settings.errorLimit);
+                unit.result = &result;
+            }
+
+            // Decoded up front, checks only read them
+            for (Unit &unit : units) {
+                if (!unit.check)
+                    continue;
+
+                for (const Target &target : unit.targets) {
+                    if (target.kind == Target::FILE)
+                        exportsOf(units[target.file]);
+                }
+            }
+
+            auto waiting = std::make_unique<std::atomic<size_t>[]>(units.size());
+            std::vector<char> done(units.size(), 0);
+
+            for (size_t i = 0; i < units.size(); i++) {
+                if (!units[i].check || !units[i].result->opened)
+                    continue;
+
+                std::vector<size_t> files;
+
+                for (const Target &target : units[i].targets) {
+                    if (target.kind == Target::FILE && target.file != i && units[target.file].check &&
+                        units[target.file].result->opened)
+                        files.push_back(target.file);
+                }
+
+                std::sort(files.begin(), files.end());
+                files.erase(std::unique(files.begin(), files.end()), files.end());
+                waiting[i] = files.size();
+
+                for (size_t file : files)
+                    units[file].dependents.push_back(i);
+            }
+
+            auto run = [&](auto &self, size_t index) -> void {
+                check(index);
+                done[index] = 1;
+
+                for (size_t dependent : units[index].dependents) {
+                    if (--waiting[dependent] == 0)
+                        pool.submit([&self, dependent] { self(self, dependent); });
+                }
+            };
+
+            // Collected before any is submitted, a finished check could
+            // otherwise release a unit this loop has yet to reach
+            std::vector<size_t> ready;
+
+            for (size_t i = 0; i < units.size(); i++) {
+                if (units[i].check && units[i].result->opened && waiting[i] == 0)
+                    ready.push_back(i);
+            }
+
+            for (size_t i : ready)
+                pool.submit([&run, i] { run(run, i); });
+
+            pool.wait();
+
+            // Whatever is left waits on a cycle; everything it imports has
+            // been parsed by now, so the order does not matter
+            for (size_t i = 0; i < units.size(); i++) {
+                if (units[i].check && units[i].result->opened && !done[i])
+                    pool.submit([this, i] { check(i); });
+            }
+
+            pool.wait();
+        }
+
+        // Records the files built without errors and drops the rest.
+        void record(BuildReport &report) {
+            std::unordered_map<std::string, FileRecord> files;
+
+            for (Unit &unit : units) {
+                report.resolved += unit.check ? unit.resolved : unit.record->resolved;
+
+                if (!unit.check) {
+                    report.upToDate++;
+                    files[unit.path] = std::move(*unit.record);
+                    continue;
+                }
+
+                changed = true;
+
+                if (!unit.result->opened || unit.result->errors.count() != 0)
+                    continue;
+
+                FileRecord record;
+
+                if (unit.record != nullptr) {
+                    record = std::move(*unit.record);
+                } else {
+                    record.tokens = unit.result->tokens;
+                    record.nodes = unit.result->nodes;
+                    record.imports = *unit.imports;
+                    record.exports = std::move(unit.encoded);
+                    record.exportsHash = unit.exportsHash;
+                }
+
+                record.fingerprint = unit.fingerprint;
+                record.resolved = unit.resolved;
+                record.dependencies = std::move(unit.dependencies);
+                files[unit.path] = std::move(record);
+            }
+
+            changed |= files.size() != state.files.size() || layout != state.layout;
+            state.files = std::move(files);
+            state.layout = layout;
+        }
+
+        void writeHeader(BuildReport &report) {
+            uint64_t hash = hashBytes(plan.header, hashBytes(plan.name));
+
+            for (const Unit &unit : units)
+                hash = hashMix(hash ^ unit.exportsHash);
+
+            std::error_code error;
+
+            if (hash == state.header && std::filesystem::exists(plan.header, error))
+                return;
+
+            auto scope = profiler.phase("header");
+            std::vector<ExportedSymbol> exports;
+
+            for (Unit &unit : units) {
+                const std::vector<ExportedSymbol> &symbols = exportsOf(unit);
+                exports.insert(exports.end(), symbols.begin(), symbols.end());
+            }
+
+            report.exported = exports.size();
+
+            if (!writeInterface(plan.header, plan.name, std::move(exports))) {
+                report.headerFailed = true;
+                return;
+            }
+
+            state.header = hash;
+            changed = true;
+        }
+
+    public:
+        Build(const BuildPlan &plan, ThreadPool &pool, SymbolTable &symbols, Profiler &profiler,
+              const BuildSettings &settings)
+                : plan(plan), pool(pool), symbols(symbols), profiler(profiler), settings(settings) {}
+
+        BuildReport run() {
+            BuildReport report;
+
+            if (!plan.state.empty()) {
+                auto scope = profiler.phase("state");
+                state = BuildState::load(plan.state);
+            }
+
+            if (!loadInterfaces(report))
+                return report;
+
+            parseChanged();
+            linkImports();
+            checkAll();
+
+            if (!plan.header.empty())
+                writeHeader(report);
+
+            record(report);
+
+            if (changed && !plan.state.empty()) {
+                auto scope = profiler.phase("state");
+                (void) state.store(plan.state);
+            }
+
+            for (Unit &unit : units) {
+                if (unit.check)
+                    report.files.push_back(std::move(*unit.result));
+            }
+
+            return report;
+        }
+    };
+}
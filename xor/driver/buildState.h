@@ -0,0 +1,387 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include "../io/atomicFile.h"
+#include "../io/sourceFile.h"
+#include "../project/interfaceFile.h"
+#include "../util/hash.h"
+#include "version.h"
+
+namespace xorLang {
+    // A file as it was when it was last built. The size and modification time
+    // tell whether to look again, the hash whether it actually changed.
+    struct Fingerprint {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        uint64_t hash = 0;
+
+        [[nodiscard]] bool sameStat(const Fingerprint &other) const {
+            return size == other.size && modified == other.modified;
+        }
+    };
+
+    // Size and modification time in nanoseconds, without the hash.
+    inline std::optional<Fingerprint> statFile(const std::string &path) {
+        struct stat info{};
+
+        if (stat(path.c_str(), &info) != 0)
+            return std::nullopt;
+
+        return Fingerprint{
+                static_cast<uint64_t>(info.st_size),
+                static_cast<int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec, 0
+        };
+    }
+
+    inline std::optional<uint64_t> hashFile(const std::string &path) {
+        std::optional<SourceFile> file = SourceFile::open(path);
+
+        if (!file.has_value())
+            return std::nullopt;
+
+        return hashBytes(file->view());
+    }
+
+    // The state file of the project at `project` (its manifest, or its only
+    // source) in `directory`, one per project and compiler.
+    inline std::filesystem::path buildStatePath(const std::filesystem::path &directory,
+                                                const std::filesystem::path &project) {
+        std::error_code error;
+        std::string absolute = std::filesystem::weakly_canonical(project, error).string();
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.state",
+                      static_cast<unsigned long long>(hashBytes(absolute, compilerFingerprint())));
+        return directory / name;
+    }
+
+    // A project file or library a file imports from, with the hash of its
+    // exports (of the interface file for a library, 0 when there is none) at
+    // the time the importer was checked. The importer is checked again once
+    // the list it would get now differs.
+    struct Dependency {
+        std::string name;
+        bool library = false;
+        uint64_t version = 0;
+
+        bool operator==(const Dependency &) const = default;
+    };
+
+    // A file that was built without errors.
+    struct FileRecord {
+        Fingerprint fingerprint;
+        uint64_t tokens = 0;
+        uint64_t nodes = 0;
+        uint64_t resolved = 0;
+        // Of `exports`
+        uint64_t exportsHash = 0;
+        std::vector<ImportPath> imports;
+        // As encodeExports() wrote them, decoded only when a file importing
+        // this one is checked or an interface is written
+        std::string exports;
+        std::vector<Dependency> dependencies;
+    };
+
+    namespace detail::state {
+        inline constexpr char magic[8] = {'X', 'O', 'R', 'B', 'U', 'I', 'L', 'D'};
+        inline constexpr uint32_t format = 1;
+        inline constexpr uint32_t byteOrder = 0x01020304;
+
+        struct Writer {
+            std::string data;
+
+            void u8(uint8_t value) {
+                data.push_back(static_cast<char>(value));
+            }
+
+            void u32(uint32_t value) {
+                data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+
+            void u64(uint64_t value) {
+                data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+
+            void text(std::string_view value) {
+                u32(static_cast<uint32_t>(value.length()));
+                data.append(value);
+            }
+        };
+
+        // Reads what Writer wrote. Past the first short read everything
+        // reads as zero and `failed` is set.
+        struct Reader {
+            std::string_view data;
+            bool failed = false;
+
+            bool take(void *to, size_t bytes) {
+                if (failed || data.length() < bytes) {
+                    failed = true;
+                    std::memset(to, 0, bytes);
+                    return false;
+                }
+
+                std::memcpy(to, data.data(), bytes);
+                data.remove_prefix(bytes);
+                return true;
+            }
+
+            uint8_t u8() {
+                uint8_t value;
+                take(&value, sizeof(value));
+                return value;
+            }
+
+            uint32_t u32() {
+                uint32_t value;
+                take(&value, sizeof(value));
+                return value;
+            }
+
+            uint64_t u64() {
+                uint64_t value;
+                take(&value, sizeof(value));
+                return value;
+            }
+
+            std::string text() {
+                uint32_t length = u32();
+
+                if (failed || data.length() < length) {
+                    failed = true;
+                    return {};
+                }
+
+                std::string value(data.substr(0, length));
+                data.remove_prefix(length);
+                return value;
+            }
+
+            // A count of items at least `minimum` bytes each, 0 when the rest
+            // of the data could not hold that many.
+            uint32_t count(size_t minimum) {
+                uint32_t value = u32();
+
+                if (value > data.length() / minimum) {
+                    failed = true;
+                    return 0;
+                }
+
+                return value;
+            }
+        };
+
+        inline void writeFingerprint(Writer &out, const Fingerprint &fingerprint) {
+            out.u64(fingerprint.size);
+            out.u64(static_cast<uint64_t>(fingerprint.modified));
+            out.u64(fingerprint.hash);
+        }
+
+        inline Fingerprint readFingerprint(Reader &in) {
+            Fingerprint fingerprint;
+            fingerprint.size = in.u64();
+            fingerprint.modified = static_cast<int64_t>(in.u64());
+            fingerprint.hash = in.u64();
+            return fingerprint;
+        }
+
+        inline void writeExports(Writer &out, const std::vector<ExportedSymbol> &exports) {
+            out.u32(static_cast<uint32_t>(exports.size()));
+
+            for (const ExportedSymbol &symbol : exports) {
+                out.u8(static_cast<uint8_t>(symbol.kind));
+                out.u8(symbol.modifiers);
+                out.text(symbol.name);
+                out.text(symbol.type);
+                out.u32(static_cast<uint32_t>(symbol.parameters.size()));
+
+                for (const ExportedParameter &parameter : symbol.parameters) {
+                    out.text(parameter.name);
+                    out.text(parameter.type);
+                    out.u8(parameter.modifiers);
+                }
+            }
+        }
+
+        inline std::vector<ExportedSymbol> readExports(Reader &in) {
+            std::vector<ExportedSymbol> exports(in.count(14));
+
+            for (ExportedSymbol &symbol : exports) {
+                symbol.kind = static_cast<SymbolKind>(in.u8());
+                symbol.modifiers = in.u8();
+                symbol.name = in.text();
+                symbol.type = in.text();
+                symbol.parameters.resize(in.count(9));
+
+                for (ExportedParameter &parameter : symbol.parameters) {
+                    parameter.name = in.text();
+                    parameter.type = in.text();
+                    parameter.modifiers = in.u8();
+                }
+            }
+
+            return exports;
+        }
+    }
+
+    inline std::string encodeExports(const std::vector<ExportedSymbol> &exports) {
+        detail::state::Writer out;
+        detail::state::writeExports(out, exports);
+        return std::move(out.data);
+    }
+
+    inline std::optional<std::vector<ExportedSymbol>> decodeExports(std::string_view data) {
+        detail::state::Reader in{data};
+        std::vector<ExportedSymbol> exports = detail::state::readExports(in);
+
+        if (in.failed || !in.data.empty())
+            return std::nullopt;
+
+        return exports;
+    }
+
+    // What the last build of a project left behind: a record per file built
+    // without errors, the fingerprints of the library interfaces it read and
+    // a hash of the interface it wrote. Kept in one file per project next to
+    // the token cache; a missing or unreadable one just means a full build.
+    struct BuildState {
+        std::unordered_map<std::string, FileRecord> files;
+        // Interface files by path
+        std::unordered_map<std::string, Fingerprint> libraries;
+        // Of the project's name and file paths, see Build
+        uint64_t layout = 0;
+        uint64_t header = 0;
+        // Modification time of the state file, i.e. when it was written
+        int64_t written = 0;
+
+        // Whether a file whose fingerprint was `recorded` is unchanged by its
+        // size and modification time alone. One modified at or after the state
+        // was written may have changed again within the same timestamp after it
+        // was fingerprinted, so it has to be hashed instead.
+        [[nodiscard]] bool unchanged(const Fingerprint &recorded, const Fingerprint &current) const {
+            return recorded.sameStat(current) && current.modified < written;
+        }
+
+        static BuildState load(const std::string &path) {
+            using namespace detail::state;
+
+            // Taken first, so a state written again since is not trusted more
+            int64_t modified = statFile(path).value_or(Fingerprint{}).modified;
+            std::optional<SourceFile> file = SourceFile::open(path);
+            BuildState state;
+
+            if (!file.has_value())
+                return state;
+
+            Reader in{file->view()};
+            char fileMagic[8];
+            in.take(fileMagic, sizeof(fileMagic));
+
+            if (std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || in.u32() != format ||
+                in.u32() != byteOrder || in.u64() != compilerFingerprint())
+                return state;
+
+            state.written = modified;
+            state.layout = in.u64();
+            state.header = in.u64();
+
+            for (uint32_t i = in.count(28); i > 0; i--) {
+                std::string name = in.text();
+                state.libraries[name] = readFingerprint(in);
+            }
+
+            for (uint32_t i = in.count(72); i > 0 && !in.failed; i--) {
+                std::string name = in.text();
+                FileRecord record;
+                record.fingerprint = readFingerprint(in);
+                record.tokens = in.u64();
+                record.nodes = in.u64();
+                record.resolved = in.u64();
+                record.exportsHash = in.u64();
+                record.imports.resize(in.count(13));
+
+                for (ImportPath &import : record.imports) {
+                    import.path = in.text();
+                    import.quoted = in.u8() != 0;
+                    import.offset = in.u32();
+                    import.length = in.u32();
+                }
+
+                record.exports = in.text();
+                record.dependencies.resize(in.count(13));
+
+                for (Dependency &dependency : record.dependencies) {
+                    dependency.name = in.text();
+                    dependency.library = in.u8() != 0;
+                    dependency.version = in.u64();
+                }
+
+                state.files[name] = std::move(record);
+            }
+
+            if (in.failed || !in.data.empty())
+                return BuildState{};
+
+            return state;
+        }
+
+        // False when the state could not be written.
+        [[nodiscard]] bool store(const std::string &path) const {
+            using namespace detail::state;
+
+            Writer out;
+            out.data.append(magic, sizeof(magic));
+            out.u32(format);
+            out.u32(byteOrder);
+            out.u64(compilerFingerprint());
+            out.u64(layout);
+            out.u64(header);
+            out.u32(static_cast<uint32_t>(libraries.size()));
+
+            for (const auto &[name, fingerprint] : libraries) {
+                out.text(name);
+                writeFingerprint(out, fingerprint);
+            }
+
+            out.u32(static_cast<uint32_t>(files.size()));
+
+            for (const auto &[name, record] : files) {
+                out.text(name);
+                writeFingerprint(out, record.fingerprint);
+                out.u64(record.tokens);
+                out.u64(record.nodes);
+                out.u64(record.resolved);
+                out.u64(record.exportsHash);
+                out.u32(static_cast<uint32_t>(record.imports.size()));
+
+                for (const ImportPath &import : record.imports) {
+                    out.text(import.path);
+                    out.u8(import.quoted);
+                    out.u32(import.offset);
+                    out.u32(import.length);
+                }
+
+                out.text(record.exports);
+                out.u32(static_cast<uint32_t>(record.dependencies.size()));
+
+                for (const Dependency &dependency : record.dependencies) {
+                    out.text(dependency.name);
+                    out.u8(dependency.library);
+                    out.u64(dependency.version);
+                }
+            }
+
+            AtomicFile file(path);
+            file.write(out.data.data(), out.data.size());
+            return file.commit();
+        }
+    };
+}
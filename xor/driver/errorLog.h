@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "../lexer/lineIndex.h"
+
+namespace xorLang {
+    inline constexpr size_t defaultErrorLimit = 100;
+
+    enum class LexErrorKind : uint8_t {
+        UNKNOWN_TOKEN, INVALID_UTF8, SYNTAX, UNRESOLVED_IMPORT
+    };
+
+    // `message` only describes SYNTAX errors and has to be a string literal.
+    struct LexError {
+        LexErrorKind kind;
+        size_t offset;
+        Position position;
+        size_t length;
+        std::string_view message;
+    };
+
+    // Collects the lexing and syntax errors of one file. Only the `limit` errors
+    // first in the file are kept and located, the rest are just counted, so a
+    // binary or minified file costs bounded memory and output no matter how much
+    // of it is garbage. Errors may be reported in any order (a file's UTF-8
+    // errors come before its lex errors); `errors` is a max-heap on the offset
+    // so the last kept one can be swapped for an earlier one.
+    class ErrorLog {
+        size_t limit;
+        size_t total = 0;
+        std::vector<LexError> errors;
+
+        static bool before(const LexError &a, const LexError &b) {
+            return a.offset != b.offset ? a.offset < b.offset : a.kind < b.kind;
+        }
+
+    public:
+        explicit ErrorLog(size_t limit = defaultErrorLimit): limit(limit) {}
+
+        // `locate` turns the offset into a Position and is only called for
+        // errors that are kept, so errors reported in source order are also
+        // located in source order.
+        template<typename Locate>
+        void report(LexErrorKind kind, size_t offset, size_t length, Locate &&locate, std::string_view message = {}) {
+            total++;
+
+            if (limit == 0)
+                return;
+
+            if (errors.size() == limit) {
+                if (offset >= errors.front().offset)
+                    return;
+
+                std::pop_heap(errors.begin(), errors.end(), before);
+                errors.pop_back();
+            }
+
+            errors.push_back(LexError{kind, offset, locate(offset), length, message});
+            std::push_heap(errors.begin(), errors.end(), before);
+        }
+
+        [[nodiscard]] size_t count() const {
+            return total;
+        }
+
+        // Prints the kept errors in source order, tagged with `file` when it is
+        // not empty.
+        void write(std::ostream &out, std::string_view file = {}) const {
+            std::vector<LexError> sorted = errors;
+
+            std::stable_sort(sorted.begin(), sorted.end(), before);
+
+            for (const LexError &error : sorted) {
+                switch (error.kind) {
+                    case LexErrorKind::UNKNOWN_TOKEN:
+                        out << "\nUnknown token found:\n";
+                        break;
+                    case LexErrorKind::INVALID_UTF8:
+                        out << "\nInvalid UTF-8 found:\n";
+                        break;
+                    case LexErrorKind::SYNTAX:
+                        out << "\nSyntax error: " << error.message << "\n";
+                        break;
+                    case LexErrorKind::UNRESOLVED_IMPORT:
+                        out << "\nUnresolved import:\n";
+                        break;
+                }
+
+                if (!file.empty())
+                    out << " -- File: " << file << "\n";
+
+                out << " -- Line & Column: " << error.position.line << " - " << error.position.column << "\n";
+
+                if (error.length > 1)
+                    out << " -- Length: " << error.length << " bytes\n";
+            }
+
+            if (total > errors.size())
+                out << "\n" << total - errors.size() << " more errors not shown" << (file.empty() ? "" : " in ")
+                    << file << "\n";
+        }
+    };
+}
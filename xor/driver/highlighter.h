@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "../lexer/tokenType.h"
+#include "../util/outputBuffer.h"
+
+namespace xorLang {
+    enum class HighlightFormat {
+        ANSI, HTML
+    };
+
+    inline std::optional<HighlightFormat> parseHighlightFormat(std::string_view name) {
+        if (name == "ansi")
+            return HighlightFormat::ANSI;
+        else if (name == "html")
+            return HighlightFormat::HTML;
+
+        return std::nullopt;
+    }
+
+    // Renders a token stream as coloured source. Adjacent tokens of the same
+    // class share one span, and whitespace never breaks a span, so a run like
+    // `pub mut fn` costs one colour change instead of three.
+    class Highlighter {
+        enum Class : uint8_t {
+            PLAIN, IDENTIFIER, KEYWORD, LITERAL, SYMBOL, DIRECTIVE, WHITESPACE
+        };
+
+        static constexpr std::array<Class, tokenTypeCount> classes = [] {
+            std::array<Class, tokenTypeCount> table{};
+
+            for (size_t i = 0; i < tokenTypeCount; i++) {
+                const TokenInfo &info = tokenInfos[i];
+
+                if (info.type == TokenType::SPACE || info.type == TokenType::TAB || info.type == TokenType::NEWLINE)
+                    table[i] = WHITESPACE;
+                else if (info.type == TokenType::IDENTIFIER)
+                    table[i] = IDENTIFIER;
+                else if (info.category == Type::LITERAL)
+                    table[i] = LITERAL;
+                else if (info.category == Type::KEYWORD)
+                    table[i] = KEYWORD;
+                else if (info.category == Type::SYMBOL)
+                    table[i] = SYMBOL;
+                else if (info.category == Type::DIRECTIVE)
+                    table[i] = DIRECTIVE;
+                else
+                    table[i] = PLAIN;
+            }
+
+            return table;
+        }();
+
+        static constexpr std::string_view ansiOpen[] = {"", "\x1b[93m", "\x1b[91m", "\x1b[32m", "\x1b[90m", "\x1b[35m"};
+        static constexpr std::string_view htmlOpen[] = {
+                "", "<span class=\"xor-id\">", "<span class=\"xor-kw\">", "<span class=\"xor-lit\">",
+                "<span class=\"xor-sym\">", "<span class=\"xor-dir\">"
+        };
+
+        OutputBuffer &out;
+        HighlightFormat format;
+        Class current = PLAIN;
+
+        void close() {
+            if (current != PLAIN)
+                out.append(format == HighlightFormat::ANSI ? "\x1b[0m" : "</span>");
+
+            current = PLAIN;
+        }
+
+        void text(std::string_view value) {
+            if (format == HighlightFormat::ANSI) {
+                out.append(value);
+                return;
+            }
+
+            size_t start = 0;
+
+            for (size_t i = 0; i < value.length(); i++) {
+                std::string_view entity;
+
+                switch (value[i]) {
+                    case '<':
+                        entity = "&lt;";
+                        break;
+                    case '>':
+                        entity = "&gt;";
+                        break;
+                    case '&':
+                        entity = "&amp;";
+                        break;
+                    default:
+                        continue;
+                }
+
+                out.append(value.substr(start, i - start));
+                out.append(entity);
+                start = i + 1;
+            }
+
+            out.append(value.substr(start));
+        }
+
+    public:
+        Highlighter(OutputBuffer &out, HighlightFormat format): out(out), format(format) {
+            if (format == HighlightFormat::HTML)
+                out.append("<pre class=\"xor\">");
+        }
+
+        void add(TokenType type, std::string_view value) {
+            Class next = classes[static_cast<size_t>(type)];
+
+            if (next != WHITESPACE && next != current) {
+                close();
+                current = next;
+                out.append(format == HighlightFormat::ANSI ? ansiOpen[next] : htmlOpen[next]);
+            }
+
+            text(value);
+        }
+
+        void finish() {
+            close();
+
+            if (format == HighlightFormat::HTML)
+                out.append("</pre>\n");
+        }
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "errorLog.h"
+#include "highlighter.h"
+#include "../lexer/target.h"
+#include "tokenCache.h"
+
+namespace xorLang {
+    struct Options {
+        // A manifest (or a directory holding xor.ini) lexes the whole project,
+        // anything else is a single file to highlight, or stdin when it is "-".
+        // A single file is built like a project when it writes or reads a
+        // library interface.
+        std::string path = "libstd/xor.ini";
+        size_t jobs = std::thread::hardware_concurrency();
+        HighlightFormat highlight = HighlightFormat::ANSI;
+        size_t maxErrors = defaultErrorLimit;
+        // Lex and parse large files on two threads at once; off by default on
+        // a single core, where the stages could only take turns
+        bool pipeline = std::thread::hardware_concurrency() > 1;
+        // Directory of the token cache and the build state, none when empty
+        std::string cache;
+        bool stats = false;
+        std::string trace;
+        // Interface of the build to write, none when empty
+        std::string header;
+        // Library name in that interface, else the project name
+        std::string name;
+        // Interfaces of the libraries imported
+        std::vector<std::string> imports;
+        // What `#[if ...]` conditions are evaluated for
+        Target target = hostTarget();
+    };
+
+    // `org_name` or `name`: not empty and at most one underscore.
+    inline bool isLibraryName(std::string_view name) {
+        return !name.empty() && std::count(name.begin(), name.end(), '_') <= 1;
+    }
+
+    inline constexpr std::string_view usage =
+            "Usage: xor [path|-] [-j N] [--highlight=ansi|html] [--max-errors=N] [--pipeline=on|off]\n"
+            "           [--cache[=DIR|off]] [--stats] [--trace=out.json] [-h out.hxor] [-n org_name]\n"
+            "           [-ih lib.hxor]... [--os=NAME] [--arch=NAME]\n"
+            "\n"
+            "With --cache, builds keep lexed files and their build state in\n"
+            "$XDG_CACHE_HOME/xor, else ~/.cache/xor, or in DIR, and only redo what\n"
+            "changed. The least recently used cached files are removed past 256 MiB.\n";
+
+    inline std::optional<Options> parseOptions(int argc, char **argv) {
+        Options options;
+
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+
+            if (arg == "-j" && i + 1 < argc) {
+                std::string_view count = argv[++i];
+                auto result = std::from_chars(count.data(), count.data() + count.length(), options.jobs);
+
+                if (result.ec != std::errc() || result.ptr != count.data() + count.length() || options.jobs == 0)
+                    return std::nullopt;
+            } else if (arg == "-h" && i + 1 < argc) {
+                options.header = argv[++i];
+            } else if (arg == "-n" && i + 1 < argc) {
+                options.name = argv[++i];
+
+                if (!isLibraryName(options.name))
+                    return std::nullopt;
+            } else if (arg == "-ih" && i + 1 < argc) {
+                options.imports.emplace_back(argv[++i]);
+            } else if (arg.starts_with("--highlight=")) {
+                std::optional<HighlightFormat> format = parseHighlightFormat(arg.substr(12));
+
+                if (!format.has_value())
+                    return std::nullopt;
+
+                options.highlight = *format;
+            } else if (arg.starts_with("--max-errors=")) {
+                std::string_view count = arg.substr(13);
+                auto result = std::from_chars(count.data(), count.data() + count.length(), options.maxErrors);
+
+                if (result.ec != std::errc() || result.ptr != count.data() + count.length())
+                    return std::nullopt;
+            } else if (arg == "--pipeline=on" || arg == "--pipeline=off") {
+                options.pipeline = arg == "--pipeline=on";
+            } else if (arg == "--cache") {
+                options.cache = defaultCacheDirectory().string();
+            } else if (arg.starts_with("--cache=")) {
+                options.cache = arg == "--cache=off" ? "" : arg.substr(8);
+            } else if (arg.starts_with("--os=")) {
+                options.target.os = arg.substr(5);
+            } else if (arg.starts_with("--arch=")) {
+                options.target.arch = arg.substr(7);
+            } else if (arg == "--stats") {
+                options.stats = true;
+            } else if (arg.starts_with("--trace=")) {
+                options.trace = arg.substr(8);
+            } else if (arg.starts_with("-") && arg != "-") {
+                return std::nullopt;
+            } else {
+                options.path = arg;
+            }
+        }
+
+        return options;
+    }
+}
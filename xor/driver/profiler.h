@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "../lexer/tokenBuffer.h"
+
+namespace xorLang {
+    // Collects per-phase timings and per-TokenType counters for the driver. Every
+    // phase of the compiler (load, lex, classify, output, and later parse or
+    // codegen) reports through phase(), optionally tagged with the file it works
+    // on. A disabled profiler records nothing and its scopes cost one branch.
+    class Profiler {
+        using Clock = std::chrono::steady_clock;
+
+        struct Event {
+            std::string_view phase;
+            std::string file;
+            uint64_t start;
+            uint64_t duration;
+            uint32_t thread;
+        };
+
+        bool enabled;
+        Clock::time_point origin = Clock::now();
+
+        std::mutex mutex;
+        std::vector<Event> events;
+        std::map<std::thread::id, uint32_t> threads;
+        std::array<std::atomic<uint64_t>, tokenTypeCount> tokenCounts{};
+
+        uint64_t now() const {
+            return static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin).count());
+        }
+
+        void record(std::string_view phase, std::string file, uint64_t start) {
+            uint64_t end = now();
+            std::lock_guard lock(mutex);
+            auto thread = threads.try_emplace(std::this_thread::get_id(), static_cast<uint32_t>(threads.size()));
+
+            events.push_back(Event{phase, std::move(file), start, end - start, thread.first->second});
+        }
+
+        static void writeEscaped(std::ostream &out, std::string_view text) {
+            for (char c : text) {
+                if (c == '"' || c == '\\')
+                    out << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20)
+                    out << ' ';
+                else
+                    out << c;
+            }
+        }
+
+    public:
+        // Times everything until it goes out of scope.
+        class Scope {
+            Profiler *profiler;
+            std::string_view phase;
+            std::string file;
+            uint64_t start;
+
+        public:
+            // `file` is only copied when `profiler` is not null.
+            Scope(Profiler *profiler, std::string_view phase, std::string_view file)
+                    : profiler(profiler), phase(phase), file(profiler != nullptr ? file : std::string_view()),
+                      start(profiler != nullptr ? profiler->now() : 0) {}
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+            ~Scope() {
+                if (profiler != nullptr)
+                    profiler->record(phase, std::move(file), start);
+            }
+        };
+
+        explicit Profiler(bool enabled = false): enabled(enabled) {}
+
+        // `phase` must outlive the profiler, it is meant to be a string literal.
+        [[nodiscard]] Scope phase(std::string_view phase, std::string_view file = {}) {
+            return Scope(enabled ? this : nullptr, phase, file);
+        }
+
+        void countTokens(const TokenBuffer &buffer) {
+            if (!enabled)
+                return;
+
+            std::array<uint64_t, tokenTypeCount> counts{};
+
+            for (uint8_t kind : buffer.kinds)
+                counts[kind]++;
+
+            for (size_t i = 0; i < tokenTypeCount; i++)
+                if (counts[i] != 0)
+                    tokenCounts[i].fetch_add(counts[i], std::memory_order_relaxed);
+        }
+
+        // Total time per phase, the slowest files, and how often each token kind
+        // was produced.
+        void writeSummary(std::ostream &out) {
+            std::lock_guard lock(mutex);
+            std::map<std::string_view, std::pair<uint64_t, size_t>> phases;
+            std::map<std::string_view, uint64_t> files;
+
+            for (const Event &event : events) {
+                auto &phase = phases[event.phase];
+                phase.first += event.duration;
+                phase.second++;
+
+                if (!event.file.empty())
+                    files[event.file] += event.duration;
+            }
+
+            out << "\nPhases (total ms, count):\n";
+
+            for (const auto &[name, phase] : phases)
+                out << "  " << name << ": " << static_cast<double>(phase.first) / 1000.0 << " ms, " << phase.second << "\n";
+
+            std::vector<std::pair<std::string_view, uint64_t>> slowest(files.begin(), files.end());
+            std::sort(slowest.begin(), slowest.end(), [](const auto &a, const auto &b) {
+                return a.second > b.second;
+            });
+
+            if (!slowest.empty()) {
+                out << "Slowest files (ms across phases):\n";
+
+                for (size_t i = 0; i < std::min<size_t>(slowest.size(), 10); i++)
+                    out << "  " << slowest[i].first << ": " << static_cast<double>(slowest[i].second) / 1000.0 << " ms\n";
+            }
+
+            out << "Tokens by kind:\n";
+
+            for (size_t i = 0; i < tokenTypeCount; i++) {
+                uint64_t count = tokenCounts[i].load(std::memory_order_relaxed);
+
+                if (count != 0)
+                    out << "  " << tokenTypeName(static_cast<TokenType>(i)) << ": " << count << "\n";
+            }
+        }
+
+        // Writes the recorded phases in the Chrome trace event format, viewable
+        // in chrome://tracing or Perfetto.
+        bool writeTrace(const std::string &path) {
+            std::ofstream out(path);
+
+            if (!out.is_open())
+                return false;
+
+            std::lock_guard lock(mutex);
+            out << "{\"traceEvents\":[";
+
+            for (size_t i = 0; i < events.size(); i++) {
+                const Event &event = events[i];
+
+                out << (i == 0 ? "\n" : ",\n") << "{\"name\":\"";
+                writeEscaped(out, event.phase);
+                out << "\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+                    << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << ",\"args\":{\"file\":\"";
+                writeEscaped(out, event.file);
+                out << "\"}}";
+            }
+
+            out << "\n]}\n";
+            return static_cast<bool>(out);
+        }
+    };
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+#include <vector>
+#include "../io/sourceFile.h"
+#include "../lexer/lineIndex.h"
+#include "../lexer/parallelLexer.h"
+#include "../lexer/utf8.h"
+#include "../parser/pipeline.h"
+#include "../project/interfaceFile.h"
+#include "../project/manifest.h"
+#include "../util/threadPool.h"
+#include "errorLog.h"
+#include "profiler.h"
+#include "tokenCache.h"
+
+namespace xorLang {
+    struct FileResult {
+        std::filesystem::path path;
+        bool opened = false;
+        // False for a file that was only checked against what it imports
+        bool parsed = false;
+        size_t tokens = 0;
+        size_t nodes = 0;
+        // Of the source text, see hashBytes()
+        uint64_t hash = 0;
+        std::vector<ImportPath> imports;
+        // Public declarations, sorted by name
+        std::vector<ExportedSymbol> exports;
+        ErrorLog errors;
+    };
+
+    // Files at least this large are split into chunks and lexed on the whole pool.
+    inline constexpr uintmax_t chunkedLexThreshold = 16 << 20;
+
+    // Files at least this large are lexed and parsed at the same time when
+    // pipelining is on; below it a thread costs more than the overlap saves.
+    inline constexpr uintmax_t pipelinedParseThreshold = 1 << 20;
+
+    struct BuildSettings {
+        size_t errorLimit = defaultErrorLimit;
+        // Lex and parse large files at the same time, see lexFile()
+        bool pipeline = false;
+        // Where lexed sources are looked up before lexing and stored after
+        const TokenCache *cache = nullptr;
+    };
+
+    // Lexes and parses one file and collects what it imports and exports. The
+    // tokens come from the cache when it has them. Otherwise the file is lexed
+    // chunk-parallel on `chunkPool` when one is given, pipelined into the
+    // parser when pipelining is on and the file is large enough, or else lexed
+    // and then parsed.
+    inline void lexFile(FileResult &result, SymbolTable &symbols, Profiler &profiler, const BuildSettings &settings,
+                        ThreadPool *chunkPool = nullptr) {
+        std::string name = result.path.string();
+        std::optional<SourceFile> file;
+
+        {
+            auto scope = profiler.phase("load", name);
+            file = SourceFile::open(name);
+        }
+
+        if (!file.has_value())
+            return;
+
+        result.opened = true;
+        result.hash = hashBytes(file->view());
+        std::optional<LineIndex> lines;
+
+        auto locate = [&](size_t offset) {
+            if (!lines.has_value())
+                lines.emplace(file->view());
+
+            return lines->position(offset);
+        };
+
+        {
+            auto scope = profiler.phase("validate", name);
+
+            forEachInvalidUtf8(file->view(), [&](size_t offset, size_t length) {
+                result.errors.report(LexErrorKind::INVALID_UTF8, offset, length, locate);
+            });
+        }
+
+        // One arena per worker thread, a file's whole tree goes with one reset
+        thread_local Arena arena;
+        TokenBuffer buffer;
+        Ast ast;
+        std::optional<TokenBuffer> cached;
+
+        if (settings.cache != nullptr) {
+            auto scope = profiler.phase("cache", name);
+            cached = settings.cache->load(file->view(), &symbols);
+        }
+
+        bool pipelined = !cached.has_value() && settings.pipeline && chunkPool == nullptr &&
+                         file->view().length() >= pipelinedParseThreshold;
+
+        if (cached.has_value()) {
+            buffer = std::move(*cached);
+        } else if (pipelined) {
+            auto scope = profiler.phase("lex+parse", name);
+            ast = parsePipelined(file->view(), buffer, arena, &symbols);
+        } else {
+            auto scope = profiler.phase("lex", name);
+            buffer = chunkPool != nullptr
+                     ? lexParallel(file->view(), *chunkPool, &symbols)
+                     : lexAll(file->view(), &symbols);
+        }
+
+        if (!cached.has_value() && settings.cache != nullptr) {
+            auto scope = profiler.phase("cache", name);
+            settings.cache->store(buffer, &symbols);
+        }
+
+        {
+            auto scope = profiler.phase("classify", name);
+            profiler.countTokens(buffer);
+
+            for (size_t i = 0; i < buffer.size(); i++) {
+                if (buffer.kind(i) != TokenType::INVALID)
+                    continue;
+
+                result.errors.report(LexErrorKind::UNKNOWN_TOKEN, buffer.offset(i), buffer.lengths[i], locate);
+            }
+
+            result.tokens = buffer.size();
+        }
+
+        if (!pipelined) {
+            auto scope = profiler.phase("parse", name);
+            ast = parse(buffer, arena);
+        }
+
+        for (const ParseError &error : ast.errors)
+            result.errors.report(LexErrorKind::SYNTAX, buffer.offset(error.token), 0, locate, error.message);
+
+        {
+            auto scope = profiler.phase("interface", name);
+            collectImports(ast, result.imports);
+            collectExports(ast, result.exports);
+
+            std::stable_sort(result.exports.begin(), result.exports.end(),
+                             [](const ExportedSymbol &a, const ExportedSymbol &b) { return a.name < b.name; });
+        }
+
+        result.parsed = true;
+        result.nodes = ast.nodes.size();
+        arena.reset();
+    }
+
+    // Lexes and parses `sources` on `pool`. Files are submitted largest first
+    // so one big file never ends up last on an otherwise idle pool, and files
+    // past chunkedLexThreshold are each split across the whole pool before
+    // that. The results come back in the order of `sources` regardless of
+    // scheduling.
+    // All files intern their identifiers into the shared `symbols` table.
+    inline std::vector<FileResult> lexSources(const std::vector<SourceEntry> &sources, ThreadPool &pool,
+                                              SymbolTable &symbols, Profiler &profiler,
+                                              const BuildSettings &settings = {}) {
+        std::vector<FileResult> results(sources.size());
+        std::vector<size_t> order(sources.size());
+
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return sources[a].size > sources[b].size;
+        });
+
+        for (size_t i : order) {
+            results[i].path = sources[i].path;
+            results[i].errors = ErrorLog(settings.errorLimit);
+
+            if (sources[i].size >= chunkedLexThreshold)
+                lexFile(results[i], symbols, profiler, settings, &pool);
+            else
+                pool.submit([&result = results[i], &symbols, &profiler, &settings] {
+                    lexFile(result, symbols, profiler, settings);
+                });
+        }
+
+        pool.wait();
+        return results;
+    }
+}
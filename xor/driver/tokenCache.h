@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include "../io/atomicFile.h"
+#include "../io/sourceFile.h"
+#include "../lexer/tokenBuffer.h"
+#include "version.h"
+
+namespace xorLang {
+    namespace detail::cache {
+        inline constexpr char magic[8] = {'X', 'O', 'R', 'T', 'O', 'K', 'S', '\n'};
+        inline constexpr uint32_t format = 1;
+        inline constexpr uint32_t byteOrder = 0x01020304;
+
+        struct Header {
+            char magic[8];
+            uint32_t format;
+            // Written natively, so a file from a machine of the other byte order never matches
+            uint32_t byteOrder;
+            uint64_t compiler;
+            // A second hash of the source with another seed, next to the one in the file name
+            uint64_t check;
+            uint64_t sourceLength;
+            uint32_t tokens;
+            uint32_t literals;
+            uint32_t names;
+            uint32_t reserved;
+        };
+
+        static_assert(sizeof(Header) == 56);
+
+        // A Literal with its padding spelled out, so equal tokens give equal files.
+        struct LiteralRecord {
+            uint64_t low;
+            uint64_t high;
+            double real;
+            uint8_t type;
+            uint8_t overflow;
+            uint8_t padding[6];
+        };
+
+        static_assert(sizeof(LiteralRecord) == 32);
+
+        // First occurrence of a distinct identifier in the source.
+        struct NameRecord {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        constexpr size_t align(size_t offset) {
+            return (offset + 63) & ~size_t{63};
+        }
+
+        // Section offsets. Every section starts on a cache line, so the kinds,
+        // offsets and lengths of a mapped file are used in place as the
+        // columns of a TokenBuffer.
+        struct Layout {
+            size_t kinds, offsets, lengths, payloads, literals, names, end;
+
+            explicit Layout(const Header &header) {
+                size_t tokens = header.tokens;
+
+                kinds = align(sizeof(Header));
+                offsets = align(kinds + tokens);
+                lengths = align(offsets + tokens * sizeof(uint32_t));
+                payloads = align(lengths + tokens * sizeof(uint32_t));
+                literals = align(payloads + tokens * sizeof(uint32_t));
+                names = align(literals + header.literals * sizeof(LiteralRecord));
+                end = names + header.names * sizeof(NameRecord);
+            }
+        };
+
+        // Sections are aligned, so the mapping can be read as T directly, and
+        // assign() spares zero-filling the vector first.
+        template<typename T>
+        void readArray(std::vector<T> &target, const char *from, size_t count) {
+            const auto *items = reinterpret_cast<const T *>(from);
+            target.assign(items, items + count);
+        }
+    }
+
+    // Bytes of entries a TokenCache keeps before prune() drops the least
+    // recently used ones.
+    inline constexpr uintmax_t defaultCacheLimit = uintmax_t{256} << 20;
+
+    // `$XDG_CACHE_HOME/xor`, else `~/.cache/xor`, else empty when neither is set.
+    inline std::filesystem::path defaultCacheDirectory() {
+        if (const char *cache = std::getenv("XDG_CACHE_HOME"); cache != nullptr && *cache != '\0')
+            return std::filesystem::path(cache) / "xor";
+
+        if (const char *home = std::getenv("HOME"); home != nullptr && *home != '\0')
+            return std::filesystem::path(home) / ".cache" / "xor";
+
+        return {};
+    }
+
+    // Lexed sources on disk, one file per distinct source text and compiler
+    // fingerprint, named after a hash of both. The tokens are stored as the
+    // arrays of a TokenBuffer. Identifier payloads are replaced by indices into
+    // a per-file table of names, and those names are interned again on load,
+    // so a hit costs a hash of the source, a pass over the tokens, a copy of
+    // the payloads and one intern per distinct name instead of a lex. The
+    // other columns stay views of the mapped entry.
+    //
+    // Entries are written through an AtomicFile and only ever replaced by a
+    // rename or removed by prune(), never truncated in place, so concurrent
+    // compilers never see half an entry and a mapped one stays readable. Loading checks that every token lies within the
+    // source but does not checksum the entry; anything that does not check
+    // out is a miss and gets overwritten by the next store. A hit bumps the
+    // entry's modification time, which prune() evicts by.
+    class TokenCache {
+        std::filesystem::path directory;
+        mutable std::atomic<bool> stored = false;
+
+        static uint64_t key(std::string_view source) {
+            return hashBytes(source, compilerFingerprint());
+        }
+
+        static uint64_t check(std::string_view source) {
+            return hashBytes(source, ~compilerFingerprint());
+        }
+
+        [[nodiscard]] std::filesystem::path entry(uint64_t key) const {
+            char name[24];
+            std::snprintf(name, sizeof(name), "%016llx.tok", static_cast<unsigned long long>(key));
+            return directory / name;
+        }
+
+    public:
+        explicit TokenCache(std::filesystem::path directory): directory(std::move(directory)) {
+            std::error_code error;
+            std::filesystem::create_directories(this->directory, error);
+        }
+
+        // The tokens lexAll(source, symbols) would return, or nullopt when
+        // they are not cached.
+        [[nodiscard]] std::optional<TokenBuffer> load(std::string_view source, SymbolTable *symbols = nullptr) const {
+            using namespace detail::cache;
+
+            std::filesystem::path path = entry(key(source));
+            std::optional<SourceFile> opened = SourceFile::open(path.string());
+
+            if (!opened.has_value() || opened->view().length() < sizeof(Header))
+                return std::nullopt;
+
+            // Shared by the columns that are views of it
+            auto file = std::make_shared<const SourceFile>(std::move(*opened));
+            const char *data = file->view().data();
+            Header header{};
+            std::memcpy(&header, data, sizeof(Header));
+
+            if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.format != format ||
+                header.byteOrder != byteOrder || header.compiler != compilerFingerprint() ||
+                header.sourceLength != source.length() || header.tokens == 0)
+                return std::nullopt;
+
+            Layout layout(header);
+
+            if (file->view().length() != layout.end || header.check != check(source))
+                return std::nullopt;
+
+            TokenBuffer buffer;
+            buffer.source = source;
+            buffer.kinds = TokenColumn<uint8_t>(reinterpret_cast<const uint8_t *>(data + layout.kinds), header.tokens, file);
+            buffer.offsets = TokenColumn<uint32_t>(reinterpret_cast<const uint32_t *>(data + layout.offsets), header.tokens, file);
+            buffer.lengths = TokenColumn<uint32_t>(reinterpret_cast<const uint32_t *>(data + layout.lengths), header.tokens, file);
+
+            std::vector<uint32_t> &payloads = buffer.payloads.edit();
+            readArray(payloads, data + layout.payloads, header.tokens);
+
+            std::vector<LiteralRecord> literals;
+            std::vector<NameRecord> names;
+            readArray(literals, data + layout.literals, header.literals);
+            readArray(names, data + layout.names, header.names);
+
+            buffer.literals.reserve(literals.size());
+
+            for (const LiteralRecord &record : literals) {
+                buffer.literals.push_back(Literal{
+                        record.low, record.high, record.real, static_cast<TokenType>(record.type), record.overflow != 0
+                });
+            }
+
+            std::vector<SymbolId> symbolIds(names.size(), 0);
+
+            for (size_t i = 0; i < names.size(); i++) {
+                if (names[i].offset > source.length() || names[i].length > source.length() - names[i].offset)
+                    return std::nullopt;
+
+                if (symbols != nullptr)
+                    symbolIds[i] = symbols->intern(source.substr(names[i].offset, names[i].length));
+            }
+
+            for (size_t i = 0; i < buffer.size(); i++) {
+                if (buffer.kinds[i] >= tokenTypeCount || buffer.offsets[i] > source.length() ||
+                    buffer.lengths[i] > source.length() - buffer.offsets[i])
+                    return std::nullopt;
+
+                if (buffer.kind(i) == TokenType::IDENTIFIER) {
+                    if (payloads[i] >= symbolIds.size())
+                        return std::nullopt;
+
+                    payloads[i] = symbolIds[payloads[i]];
+                } else if (hasLiteral(buffer.kind(i)) && payloads[i] >= buffer.literals.size()) {
+                    return std::nullopt;
+                }
+            }
+
+            if (buffer.kind(buffer.size() - 1) != TokenType::EOI)
+                return std::nullopt;
+
+            std::error_code error;
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+            return buffer;
+        }
+
+        // Caches a buffer from lexAll() or lexParallel(). `symbols` is the
+        // table it was lexed with, if any, which makes telling identifiers
+        // apart cheaper. False when the entry could not be written.
+        bool store(const TokenBuffer &buffer, const SymbolTable *symbols = nullptr) const {
+            using namespace detail::cache;
+            assert(buffer.shiftFrom == TokenBuffer::unshifted);
+
+            Header header{};
+            std::memcpy(header.magic, magic, sizeof(magic));
+            header.format = format;
+            header.byteOrder = byteOrder;
+            header.compiler = compilerFingerprint();
+            header.check = check(buffer.source);
+            header.sourceLength = buffer.source.length();
+            header.tokens = static_cast<uint32_t>(buffer.size());
+            header.literals = static_cast<uint32_t>(buffer.literals.size());
+
+            std::vector<uint32_t> payloads(buffer.payloads.begin(), buffer.payloads.end());
+            std::vector<NameRecord> names;
+            std::unordered_map<uint32_t, uint32_t> bySymbol;
+            std::unordered_map<std::string_view, uint32_t> bySpelling;
+
+            auto local = [&](auto &map, auto name, size_t token) {
+                auto [it, inserted] = map.try_emplace(name, static_cast<uint32_t>(names.size()));
+
+                if (inserted)
+                    names.push_back(NameRecord{buffer.offsets[token], buffer.lengths[token]});
+
+                return it->second;
+            };
+
+            for (size_t i = 0; i < buffer.size(); i++) {
+                if (buffer.kind(i) != TokenType::IDENTIFIER)
+                    continue;
+
+                payloads[i] = symbols != nullptr ? local(bySymbol, buffer.payloads[i], i)
+                                                 : local(bySpelling, buffer.value(i), i);
+            }
+
+            header.names = static_cast<uint32_t>(names.size());
+
+            std::vector<LiteralRecord> literals;
+            literals.reserve(buffer.literals.size());
+
+            for (const Literal &literal : buffer.literals) {
+                literals.push_back(LiteralRecord{
+                        literal.low, literal.high, literal.real, static_cast<uint8_t>(literal.type), literal.overflow, {}
+                });
+            }
+
+            Layout layout(header);
+            AtomicFile out(entry(key(buffer.source)).string());
+
+            out.write(&header, sizeof(Header));
+            out.padTo(layout.kinds);
+            out.write(buffer.kinds.data(), buffer.size());
+            out.padTo(layout.offsets);
+            out.write(buffer.offsets.data(), buffer.size() * sizeof(uint32_t));
+            out.padTo(layout.lengths);
+            out.write(buffer.lengths.data(), buffer.size() * sizeof(uint32_t));
+            out.padTo(layout.payloads);
+            out.write(payloads.data(), payloads.size() * sizeof(uint32_t));
+            out.padTo(layout.literals);
+            out.write(literals.data(), literals.size() * sizeof(LiteralRecord));
+            out.padTo(layout.names);
+            out.write(names.data(), names.size() * sizeof(NameRecord));
+
+            bool written = out.size() == layout.end && out.commit();
+            if (written)
+                stored = true;
+
+            return written;
+        }
+
+        // Removes the least recently used entries until the rest take at most
+        // `limit` bytes. Only looks at the directory if an entry was stored
+        // since the last call; other files in it are left alone.
+        void prune(uintmax_t limit = defaultCacheLimit) const {
+            if (!stored.exchange(false))
+                return;
+
+            struct Entry {
+                std::filesystem::file_time_type used;
+                uintmax_t size;
+                std::filesystem::path path;
+            };
+
+            std::vector<Entry> entries;
+            uintmax_t total = 0;
+            std::error_code error;
+
+            for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+                std::error_code unreadable;
+
+                if (it->path().extension() != ".tok" || !it->is_regular_file(unreadable))
+                    continue;
+
+                Entry entry{it->last_write_time(unreadable), it->file_size(unreadable), it->path()};
+
+                if (unreadable)
+                    continue;
+
+                total += entry.size;
+                entries.push_back(std::move(entry));
+            }
+
+            std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+                return a.used < b.used;
+            });
+
+            for (size_t i = 0; i < entries.size() && total > limit; i++)
+                if (std::filesystem::remove(entries[i].path, error))
+                    total -= entries[i].size;
+        }
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include "../lexer/target.h"
+#include "../lexer/tokenType.h"
+#include "../util/hash.h"
+
+namespace xorLang {
+    // Bump with every change to what the lexer produces for the same input, so
+    // caches written by older builds are never read back.
+    inline constexpr std::string_view compilerVersion = "0.2.0";
+
+    // Identifies the output of this build of the compiler: the version plus
+    // the token registry, so renumbering or adding a token kind invalidates
+    // cached tokens even without a version bump, plus the current target,
+    // which decides the branches of `#[if ...]` the lexer skips.
+    inline uint64_t compilerFingerprint() {
+        static const uint64_t fingerprint = [] {
+            uint64_t hash = hashBytes(compilerVersion);
+
+            for (const TokenInfo &info : tokenInfos)
+                hash = hashBytes(info.name, hash);
+
+            return hash;
+        }();
+
+        return hashBytes(currentTarget().arch, hashBytes(currentTarget().os, fingerprint));
+    }
+}
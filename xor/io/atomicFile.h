@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <unistd.h>
+
+namespace xorLang {
+    // Writes a file next to its final path and renames it into place on
+    // commit(), so readers see either the old file or the complete new one.
+    // Writes after the first failure are dropped and make commit() fail.
+    class AtomicFile {
+        std::string target;
+        std::string temporary;
+        int fd = -1;
+        size_t position = 0;
+        bool failed = false;
+
+        void discard() {
+            if (fd >= 0) {
+                close(fd);
+                std::remove(temporary.c_str());
+            }
+
+            fd = -1;
+        }
+
+    public:
+        explicit AtomicFile(std::string path): target(std::move(path)), temporary(target + ".XXXXXX") {
+            fd = mkstemp(temporary.data());
+            failed = fd < 0;
+        }
+
+        AtomicFile(const AtomicFile &) = delete;
+        AtomicFile &operator=(const AtomicFile &) = delete;
+
+        ~AtomicFile() {
+            discard();
+        }
+
+        void write(const void *data, size_t bytes) {
+            const auto *from = static_cast<const char *>(data);
+
+            while (bytes > 0 && !failed) {
+                ssize_t count = ::write(fd, from, bytes);
+
+                if (count < 0 && errno == EINTR)
+                    continue;
+
+                if (count <= 0) {
+                    failed = true;
+                    break;
+                }
+
+                from += count;
+                bytes -= static_cast<size_t>(count);
+                position += static_cast<size_t>(count);
+            }
+        }
+
+        // Zero fills up to `offset`, e.g. to align the next section.
+        void padTo(size_t offset) {
+            static constexpr char zeros[64] = {};
+
+            while (position < offset && !failed)
+                write(zeros, std::min(sizeof(zeros), offset - position));
+        }
+
+        [[nodiscard]] size_t size() const {
+            return position;
+        }
+
+        // Renames the file into place; false, leaving nothing behind, when any
+        // write failed.
+        bool commit() {
+            if (failed) {
+                discard();
+                return false;
+            }
+
+            bool closed = close(fd) == 0;
+            fd = -1;
+
+            if (!closed || std::rename(temporary.c_str(), target.c_str()) != 0) {
+                std::remove(temporary.c_str());
+                return false;
+            }
+
+            return true;
+        }
+    };
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xorLang {
+    // How a mapped file is going to be read, passed on to the kernel so it
+    // reads ahead for a scan and only faults in the touched pages otherwise.
+    enum class FileAccess : uint8_t {
+        SEQUENTIAL, RANDOM
+    };
+
+    // A read-only view of a source file. Regular files are memory mapped so the
+    // lexer reads straight from the page cache; pipes, terminals and stdin ("-")
+    // are read once into an owned buffer instead.
+    class SourceFile {
+        std::string path;
+        const char *mapped = nullptr;
+        size_t mappedSize = 0;
+        std::string buffer;
+
+        explicit SourceFile(std::string path): path(std::move(path)) {}
+
+        bool map(int fd, size_t size, FileAccess access) {
+            if (size == 0)
+                return true;
+
+            void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (address == MAP_FAILED)
+                return false;
+
+            madvise(address, size, access == FileAccess::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+            mapped = static_cast<const char *>(address);
+            mappedSize = size;
+            return true;
+        }
+
+        void release() {
+            if (mapped != nullptr)
+                munmap(const_cast<char *>(mapped), mappedSize);
+
+            mapped = nullptr;
+            mappedSize = 0;
+        }
+
+        bool read(int fd) {
+            char chunk[64 * 1024];
+
+            while (true) {
+                ssize_t count = ::read(fd, chunk, sizeof(chunk));
+
+                if (count == 0)
+                    return true;
+
+                if (count < 0)
+                    return false;
+
+                buffer.append(chunk, static_cast<size_t>(count));
+            }
+        }
+
+    public:
+        static std::optional<SourceFile> open(std::string path, FileAccess access = FileAccess::SEQUENTIAL) {
+            bool fromStdin = path == "-";
+            int fd = fromStdin ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+            if (fd < 0)
+                return std::nullopt;
+
+            SourceFile file(std::move(path));
+            struct stat info{};
+            bool loaded;
+
+            if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+                loaded = file.map(fd, static_cast<size_t>(info.st_size), access) || file.read(fd);
+            else
+                loaded = file.read(fd);
+
+            if (!fromStdin)
+                close(fd);
+
+            if (!loaded)
+                return std::nullopt;
+
+            return file;
+        }
+
+        SourceFile(SourceFile &&other) noexcept
+                : path(std::move(other.path)), mapped(std::exchange(other.mapped, nullptr)),
+                  mappedSize(std::exchange(other.mappedSize, 0)), buffer(std::move(other.buffer)) {}
+
+        SourceFile &operator=(SourceFile &&other) noexcept {
+            if (this != &other) {
+                release();
+                path = std::move(other.path);
+                mapped = std::exchange(other.mapped, nullptr);
+                mappedSize = std::exchange(other.mappedSize, 0);
+                buffer = std::move(other.buffer);
+            }
+
+            return *this;
+        }
+
+        SourceFile(const SourceFile &) = delete;
+        SourceFile &operator=(const SourceFile &) = delete;
+
+        ~SourceFile() {
+            release();
+        }
+
+        [[nodiscard]] std::string_view view() const {
+            if (mapped != nullptr)
+                return {mapped, mappedSize};
+
+            return buffer;
+        }
+
+        [[nodiscard]] const std::string &getPath() const {
+            return path;
+        }
+
+        [[nodiscard]] bool isMapped() const {
+            return mapped != nullptr;
+        }
+    };
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tokenBuffer.h"
+
+namespace xorLang {
+    // Old tokens [begin, begin + removed) were replaced by the new tokens
+    // [begin, begin + inserted) of the buffer.
+    struct TokenRange {
+        size_t begin;
+        size_t removed;
+        size_t inserted;
+    };
+
+    namespace detail {
+        // Moves the start of the pending shift of `buffer` to token `to`, at
+        // the cost of the tokens between the old and the new start.
+        inline void moveShift(TokenBuffer &buffer, size_t to) {
+            if (buffer.shiftFrom > buffer.size()) {
+                buffer.shiftFrom = buffer.size();
+                buffer.shift = 0;
+            }
+
+            std::vector<uint32_t> &offsets = buffer.offsets.edit();
+
+            for (size_t i = to; i < buffer.shiftFrom; i++)
+                offsets[i] -= buffer.shift;
+
+            for (size_t i = buffer.shiftFrom; i < to; i++)
+                offsets[i] += buffer.shift;
+
+            buffer.shiftFrom = to;
+        }
+
+        // Index of the first token starting at or after `offset`.
+        inline size_t firstTokenAt(const TokenBuffer &buffer, size_t offset) {
+            size_t low = 0;
+            size_t high = buffer.size();
+
+            while (low < high) {
+                size_t middle = low + (high - low) / 2;
+
+                if (buffer.offset(middle) < offset)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+
+            return low;
+        }
+    }
+
+    // Replaces `length` bytes of `text` at `offset` with `replacement` and
+    // updates `buffer`, a lexAll() of the old text, to match the new text.
+    //
+    // A token only depends on the bytes from its start up to two bytes past its
+    // end: a number looks at `1.x` to tell a fraction from a member access.
+    // Tokens that search further ahead, a directive for its `]`, an inactive
+    // `#[if]` or `#[else]` for its `#[end if]` and `#[asm]` for `#[end asm]`,
+    // span everything they searched, as a rejected run when they found nothing.
+    // So every token is kept that ends before `offset` and is not one of the
+    // two tokens right before the edit. Re-lexing starts at the first of those
+    // two and stops as soon as a new token starts where an old token past the
+    // edit started (shifted by the size change). Everything from there on is only
+    // moved, by adding the size change to the buffer's pending shift, so an
+    // edit costs the tokens it touches and the tokens between it and the
+    // previous edit, not the tokens after it. Slots of replaced literals are
+    // reused for new ones.
+    inline TokenRange relex(TokenBuffer &buffer, std::string &text, size_t offset, size_t length,
+                            std::string_view replacement, SymbolTable *symbols = nullptr) {
+        text.replace(offset, length, replacement);
+        buffer.source = text;
+
+        // The trailing EOI is re-added once the rest is in place
+        buffer.kinds.pop_back();
+        buffer.offsets.pop_back();
+        buffer.lengths.pop_back();
+        buffer.payloads.pop_back();
+
+        auto delta = static_cast<int64_t>(replacement.length()) - static_cast<int64_t>(length);
+        size_t oldEditEnd = offset + length;
+        size_t newEditEnd = offset + replacement.length();
+
+        // Tokens tile the text, so the last one starting before `offset` is the
+        // first one that reaches it. The one before that may have looked at it.
+        size_t begin = detail::firstTokenAt(buffer, offset);
+
+        begin -= std::min<size_t>(begin, 2);
+
+        size_t position = begin < buffer.size() ? buffer.offset(begin) : std::min<size_t>(buffer.end(), offset);
+        size_t synced = begin;
+        TokenBuffer fresh;
+        fresh.source = text;
+
+        Lexer lexer(text, position, symbols);
+
+        while (true) {
+            if (position >= newEditEnd) {
+                auto old = static_cast<size_t>(static_cast<int64_t>(position) - delta);
+
+                while (synced < buffer.size() && (buffer.offset(synced) < old || buffer.offset(synced) < oldEditEnd))
+                    synced++;
+
+                if (synced < buffer.size() && buffer.offset(synced) == old)
+                    break;
+            }
+
+            if (!lexer.hasNext()) {
+                synced = buffer.size();
+                break;
+            }
+
+            auto token = lexer.next();
+
+            if (token.has_value())
+                fresh.push(*token);
+            else
+                fresh.push(TokenType::INVALID, position, lexer.getIndex() - position);
+
+            position = lexer.getIndex();
+        }
+
+        detail::moveShift(buffer, synced);
+        buffer.shift += static_cast<uint32_t>(delta);
+
+        auto splice = [&](auto &column, const auto &source) {
+            auto &target = column.edit();
+            auto first = target.begin() + static_cast<std::ptrdiff_t>(begin);
+            auto last = target.begin() + static_cast<std::ptrdiff_t>(synced);
+            size_t common = std::min(source.size(), synced - begin);
+
+            std::copy_n(source.begin(), common, first);
+
+            if (source.size() > common)
+                target.insert(first + static_cast<std::ptrdiff_t>(common), source.begin() + static_cast<std::ptrdiff_t>(common), source.end());
+            else
+                target.erase(first + static_cast<std::ptrdiff_t>(common), last);
+        };
+
+        for (size_t i = begin; i < synced; i++)
+            if (hasLiteral(buffer.kind(i)))
+                buffer.freeLiterals.push_back(buffer.payloads[i]);
+
+        std::vector<uint32_t> &freshPayloads = fresh.payloads.edit();
+
+        for (size_t i = 0; i < fresh.size(); i++) {
+            if (!hasLiteral(fresh.kind(i)))
+                continue;
+
+            const Literal &literal = fresh.literals[freshPayloads[i]];
+
+            if (buffer.freeLiterals.empty()) {
+                freshPayloads[i] = static_cast<uint32_t>(buffer.literals.size());
+                buffer.literals.push_back(literal);
+            } else {
+                freshPayloads[i] = buffer.freeLiterals.back();
+                buffer.freeLiterals.pop_back();
+                buffer.literals[freshPayloads[i]] = literal;
+            }
+        }
+
+        splice(buffer.kinds, fresh.kinds);
+        splice(buffer.offsets, fresh.offsets);
+        splice(buffer.lengths, fresh.lengths);
+        splice(buffer.payloads, fresh.payloads);
+
+        buffer.shiftFrom = begin + fresh.size();
+        buffer.push(TokenType::EOI, static_cast<uint32_t>(text.length()) - buffer.shift, 0);
+
+        return TokenRange{
+                .begin = begin,
+                .removed = synced - begin,
+                .inserted = fresh.size()
+        };
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "tokenType.h"
+
+namespace xorLang {
+    struct Keyword {
+        std::string_view spelling;
+        TokenType type;
+    };
+
+    namespace detail {
+        // Spellings accepted besides the canonical one in tokenInfos.
+        inline constexpr Keyword keywordAliases[] = {
+                {"ret", TokenType::RETURN},
+        };
+
+        constexpr bool isWordSpelling(std::string_view spelling) {
+            return !spelling.empty() && (spelling[0] == '_' || (spelling[0] >= 'a' && spelling[0] <= 'z'));
+        }
+
+        constexpr size_t keywordCount() {
+            size_t count = std::size(keywordAliases);
+
+            for (const TokenInfo &info : tokenInfos)
+                count += isWordSpelling(info.spelling);
+
+            return count;
+        }
+    }
+
+    // Every reserved word of the language: each token kind with an alphabetic
+    // canonical spelling in tokenInfos, plus the aliases above. Kinds the
+    // language does not define yet, e.g. IN, AS, PROTECTED or INT_MAXBIT, have
+    // no spelling, so their words stay free for identifiers.
+    inline constexpr std::array<Keyword, detail::keywordCount()> keywords = [] {
+        std::array<Keyword, detail::keywordCount()> table{};
+        size_t count = 0;
+
+        for (const TokenInfo &info : tokenInfos)
+            if (detail::isWordSpelling(info.spelling))
+                table[count++] = Keyword{info.spelling, info.type};
+
+        for (const Keyword &alias : detail::keywordAliases)
+            table[count++] = alias;
+
+        return table;
+    }();
+
+    namespace detail {
+        inline constexpr size_t keywordSlots = 512;
+
+        struct KeywordTable {
+            uint32_t seed = 0;
+            size_t maxLength = 0;
+            // Index into `keywords` plus one for every hash slot, zero when empty.
+            std::array<uint8_t, keywordSlots> slots{};
+        };
+
+        constexpr uint32_t keywordHash(std::string_view word, uint32_t seed) {
+            uint32_t hash = seed ^ static_cast<uint32_t>(word.length());
+
+            for (char c : word)
+                hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+
+            return (hash ^ (hash >> 15)) & (keywordSlots - 1);
+        }
+
+        // Searches for a seed under which no two keywords share a slot.
+        constexpr KeywordTable buildKeywordTable() {
+            static_assert(std::size(keywords) < 255);
+
+            for (uint32_t seed = 1;; seed++) {
+                KeywordTable table{.seed = seed};
+                bool collision = false;
+
+                for (size_t i = 0; i < std::size(keywords) && !collision; i++) {
+                    uint8_t &slot = table.slots[keywordHash(keywords[i].spelling, seed)];
+
+                    collision = slot != 0;
+                    slot = static_cast<uint8_t>(i + 1);
+
+                    if (keywords[i].spelling.length() > table.maxLength)
+                        table.maxLength = keywords[i].spelling.length();
+                }
+
+                if (!collision)
+                    return table;
+            }
+        }
+
+        inline constexpr KeywordTable keywordTable = buildKeywordTable();
+    }
+
+    // Classifies a scanned identifier: one hash, one slot load and one compare.
+    inline std::optional<TokenType> lookupKeyword(std::string_view word) {
+        if (word.length() > detail::keywordTable.maxLength)
+            return std::nullopt;
+
+        uint8_t slot = detail::keywordTable.slots[detail::keywordHash(word, detail::keywordTable.seed)];
+
+        if (slot == 0 || keywords[slot - 1].spelling != word)
+            return std::nullopt;
+
+        return keywords[slot - 1].type;
+    }
+}
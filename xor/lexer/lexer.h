@@ -1,772 +1,409 @@
 #pragma once
 
-#include <string>
-#include <utility>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
 #include <optional>
+#include "tokenType.h"
+#include "keywords.h"
+#include "literal.h"
+#include "scan.h"
+#include "target.h"
+#include "../util/symbolTable.h"
 
 namespace xorLang {
-    enum class TokenType {
-        // File
-        NEWLINE, SPACE, TAB, EOI, COMMENT,
-
-        // Symbols [D_ = Double, T_ = Triple]
-        D_L_PAREN, L_PAREN, D_R_PAREN, R_PAREN, D_L_BRACE, L_BRACE, D_R_BRACE,
-        R_BRACE, SEMICOLON, RETURN_ARROW, D_L_ANGLE, L_ANGLE, D_R_ANGLE, R_ANGLE,
-        D_L_BRACKET, L_BRACKET, D_R_BRACKET, R_BRACKET, COMMA, D_DOT, DOT, D_COLON,
-        COLON, HASH, AT, SUBTRACT, PLUS, STAR, SLASH, PLUS_EQ, START_EQ, SLASH_EQ,
-        SUBTRACT_EQ, BACK_TICK,
-
-        // Reserved keywords [UN = Unsafe]
-        FN, RETURN, CLASS, IF, ELSE, WHILE, FOR, IN, BREAK, CONTINUE, IMPORT, AS,
-        FROM, NULL_KW, SELF, SUPER, STATIC, CONST, MUT, ENUM, STRUCT,
-        UNION, TYPE, PUBLIC, PRIVATE, PROTECTED, EXTENDS, IMPLEMENTS, INSTANCE_OF,
-        UNSAFE, UN_DELETE, UN_CXX, UN_C, UN_ASM, UN_EXPOSE, FRIEND,
-
-        // Reserved data types [UN = Unsafe]
-        INT_8BIT, INT_16BIT, INT_32BIT, INT_64BIT, INT_128BIT,
-        UINT_8BIT, UINT_16BIT, UINT_32BIT, UINT_64BIT, UINT_128BIT,
-        FLOAT_32BIT, FLOAT_64BIT, BOOL, CHAR, VOID, UN_VOID, INT_MAX,
-        UINT_MAX, FLOAT_MAX,
-
-        // Literals
-        IDENTIFIER, DECIMAL_NUMBER, NUMBER, STRING, CHAR_LIT, TRUE, FALSE, NULL_LIT
-    };
-    
-    enum class Type {
-        SYMBOL, FILE, LITERAL, KEYWORD
-    };
-    
-    Type getTypeCat(TokenType type) {
-        switch (type) {
-            case TokenType::NEWLINE:
-            case TokenType::SPACE:
-            case TokenType::TAB:
-            case TokenType::EOI:
-            case TokenType::COMMENT:
-                return Type::FILE;
-
-            case TokenType::D_L_PAREN:
-            case TokenType::L_PAREN:
-            case TokenType::D_R_PAREN:
-            case TokenType::R_PAREN:
-            case TokenType::D_L_BRACE:
-            case TokenType::L_BRACE:
-            case TokenType::D_R_BRACE:
-            case TokenType::R_BRACE:
-            case TokenType::SEMICOLON:
-            case TokenType::RETURN_ARROW:
-            case TokenType::D_L_ANGLE:
-            case TokenType::L_ANGLE:
-            case TokenType::D_R_ANGLE:
-            case TokenType::R_ANGLE:
-            case TokenType::D_L_BRACKET:
-            case TokenType::L_BRACKET:
-            case TokenType::D_R_BRACKET:
-            case TokenType::R_BRACKET:
-            case TokenType::COMMA:
-            case TokenType::D_DOT:
-            case TokenType::DOT:
-            case TokenType::D_COLON:
-            case TokenType::COLON:
-            case TokenType::HASH:
-            case TokenType::AT:
-            case TokenType::SUBTRACT:
-            case TokenType::PLUS:
-            case TokenType::STAR:
-            case TokenType::SLASH:
-            case TokenType::PLUS_EQ:
-            case TokenType::START_EQ:
-            case TokenType::SLASH_EQ:
-            case TokenType::SUBTRACT_EQ:
-            case TokenType::BACK_TICK:
-                return Type::SYMBOL;
-
-            case TokenType::FN:
-            case TokenType::RETURN:
-                return Type::KEYWORD;
-        }
-    }
-
+    // A token never owns its spelling, `value` is a view into the lexed source
+    // buffer and is only valid for as long as that buffer is. Only the byte
+    // offset is kept, a LineIndex resolves it to a line and column on demand.
+    // `payload` is the SymbolId of an IDENTIFIER when lexing with a SymbolTable,
+    // `literal` the decoded value of a NUMBER, DECIMAL_NUMBER or CHAR_LIT.
     struct Token {
         TokenType type;
-        std::string value;
-
-        size_t line;
-        size_t column;
-        size_t index;
+        std::string_view value;
+        size_t offset;
+        uint32_t payload = 0;
+        Literal literal{};
     };
 
-    class Lexer {
-        std::string input;
-        size_t line = 0;
-        size_t column = 0;
-        size_t index = 0;
+    namespace detail {
+        // Bytes some token can start with. Anything else is rejected together
+        // with the bytes after it up to the next one of these.
+        inline constexpr std::array<bool, 256> tokenStarts = [] {
+            std::array<bool, 256> table{};
 
-    public:
-        explicit Lexer(std::string input): input(std::move(input)) {}
+            for (char c : std::string_view("\n \t/(){}<>[].:;,#@&-+*=`\"'_"))
+                table[static_cast<uint8_t>(c)] = true;
 
-        std::optional<Token> next() {
-            if (input.length() == 0)
-                return Token{
-                        TokenType::EOI,
-                        "EOI",
-                        line,
-                        column,
-                        index
-                };
+            for (int c = 0; c < 10; c++)
+                table['0' + c] = true;
 
-            if (input[0] == '\n') {
-                line++;
-                column = 0;
+            for (int c = 0; c < 26; c++)
+                table['a' + c] = table['A' + c] = true;
 
-                input.erase(0, 1);
-                index++;
+            for (int c = 0x80; c < 0x100; c++)
+                table[c] = true;
 
-                return Token{
-                        .type = TokenType::NEWLINE,
-                        .value = "\n",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == ' ') {
-                column++;
+            return table;
+        }();
 
-                input.erase(0, 1);
-                index++;
+        // Offset just past the `]` of the directive whose `#[` is at `at`, or
+        // npos when its line ends first. A quoted value may hold a `]` unless
+        // `quotes` is false.
+        inline size_t directiveEnd(std::string_view input, size_t at, bool quotes = true) {
+            for (size_t i = at + 2; i < input.length(); i++) {
+                if (input[i] == ']')
+                    return i + 1;
 
-                return Token{
-                        .type = TokenType::SPACE,
-                        .value = " ",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == '\t') {
-                column++;
+                if (input[i] == '\n')
+                    break;
 
-                input.erase(0, 1);
-                index++;
+                if (input[i] == '"' && quotes) {
+                    i = input.find_first_of("\"\n", i + 1);
 
-                return Token{
-                        .type = TokenType::TAB,
-                        .value = "\t",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == '/') {
-                if (input[1] == '/') {
-                    input.erase(0, 2);
-                    index++;
+                    if (i == std::string_view::npos || input[i] == '\n')
+                        break;
+                }
+            }
 
-                    std::string comment = "//";
+            return std::string_view::npos;
+        }
 
-                    while (input[0] != '\n') {
-                        comment += input[0];
-                        input.erase(0, 1);
-                        index++;
-                    }
+        inline std::string_view trimSpaces(std::string_view text) {
+            size_t first = text.find_first_not_of(" \t");
 
-                    column += comment.length();
+            if (first == std::string_view::npos)
+                return {};
 
-                    return Token{
-                            .type = TokenType::COMMENT,
-                            .value = comment,
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '(') {
-                if (input[1] == '(') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_L_PAREN,
-                            .value = "((",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::L_PAREN,
-                            .value = "(",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == ')') {
-                if (input[1] == ')') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_R_PAREN,
-                            .value = "))",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::R_PAREN,
-                            .value = ")",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '{') {
-                if (input[1] == '{') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_L_BRACE,
-                            .value = "{{",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::L_BRACE,
-                            .value = "{",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '}') {
-                if (input[1] == '}') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_R_BRACE,
-                            .value = "}}",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::R_BRACE,
-                            .value = "}",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == ';') {
-                input.erase(0, 1);
-                index++;
-                column++;
+            return text.substr(first, text.find_last_not_of(" \t") + 1 - first);
+        }
 
-                return Token{
-                        .type = TokenType::SEMICOLON,
-                        .value = ";",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == '-') {
-                if (input[1] == '>') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token {
-                            .type = TokenType::RETURN_ARROW,
-                            .value = "->",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token {
-                         .type = TokenType::SUBTRACT,
-                         .value = "-",
-                         .line = line,
-                         .column = column,
-                         .index = index
-                    };
-                }
-            } else if (input[0] == '<') {
-                if (input[1] == '<') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_L_ANGLE,
-                            .value = "<<",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::L_ANGLE,
-                            .value = "<",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '>') {
-                if (input[1] == '>') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_R_ANGLE,
-                            .value = ">>",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::R_ANGLE,
-                            .value = ">",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '[') {
-                if (input[1] == '[') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_L_BRACKET,
-                            .value = "[[",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::L_BRACKET,
-                            .value = "[",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == ']') {
-                if (input[1] == ']') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_R_BRACKET,
-                            .value = "]]",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::R_BRACKET,
-                            .value = "]",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == ',') {
-                input.erase(0, 1);
-                index++;
-                column++;
+        // The name of a directive spanning [at, end) and the text after it.
+        struct DirectiveHead {
+            std::string_view name;
+            std::string_view rest;
+        };
 
-                return Token{
-                        .type = TokenType::COMMA,
-                        .value = ",",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == '.') {
-                if (input[1] == '.') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_DOT,
-                            .value = "..",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::DOT,
-                            .value = ".",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == ':') {
-                if (input[1] == ':') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::D_COLON,
-                            .value = "::",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column++;
-
-                    return Token{
-                            .type = TokenType::COLON,
-                            .value = ":",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '#') {
-                input.erase(0, 1);
-                index++;
-                column++;
+        inline DirectiveHead directiveHead(std::string_view input, size_t at, size_t end) {
+            std::string_view body = trimSpaces(input.substr(at + 2, end - 1 - (at + 2)));
+            size_t length = 0;
 
-                return Token{
-                        .type = TokenType::HASH,
-                        .value = "#",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == '@') {
-                input.erase(0, 1);
-                index++;
-                column++;
+            while (length < body.length() && isIdentifierByte(body[length]))
+                length++;
 
-                return Token{
-                        .type = TokenType::AT,
-                        .value = "@",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == '+') {
-                if (input[1] == '=') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::PLUS_EQ,
-                            .value = "+=",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::PLUS,
-                            .value = "+",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '-') {
-                if (input[1] == '=') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::SUBTRACT_EQ,
-                            .value = "-=",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::SUBTRACT,
-                            .value = "-",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '*') {
-                if (input[1] == '=') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::START_EQ,
-                            .value = "*=",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::STAR,
-                            .value = "*",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '/') {
-                if (input[1] == '=') {
-                    input.erase(0, 2);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::SLASH_EQ,
-                            .value = "/=",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                } else {
-                    input.erase(0, 1);
-                    index++;
-                    column += 2;
-
-                    return Token{
-                            .type = TokenType::SLASH,
-                            .value = "/",
-                            .line = line,
-                            .column = column,
-                            .index = index
-                    };
-                }
-            } else if (input[0] == '`') {
-                input.erase(0, 1);
-                std::string res = "`";
-                index++;
-
-                size_t escape = 0;
-
-                while (true) {
-                    if (input.length() == 0)
-                        return std::nullopt;
-
-                    if (input[0] == '`') {
-                        if (escape != 0) {
-                            escape = 0;
-                            res += input[0];
-                        } else {
-                            res += "`";
-                            break;
-                        }
-                    } else {
-                        if (input[0] == '\\') {
-                            res += '\\';
-                            escape++;
-                        } else {
-                            escape = 0;
-                            res += input[0];
-                        }
-                    }
+            return DirectiveHead{body.substr(0, length), trimSpaces(body.substr(length))};
+        }
 
-                    input.erase(0, 1);
+        // Offset just past the `#[end <name>]` closing a block whose body
+        // starts at `from`, skipping blocks of the same name nested inside it,
+        // or npos when there is none. With `toElse` an `#[else]` of the block
+        // ends it as well. The body is never lexed, so the closing directive
+        // is found even inside what would be a string or a comment, and quotes
+        // are not matched within directives either: a quote could only be
+        // closed past the end of the block, making the token depend on what
+        // follows it.
+        inline size_t blockEnd(std::string_view input, size_t from, std::string_view name, bool toElse) {
+            size_t depth = 0;
+
+            while ((from = scanFor(input, from, '#')) < input.length()) {
+                size_t end = from + 1 < input.length() && input[from + 1] == '[' ? directiveEnd(input, from, false)
+                                                                                  : std::string_view::npos;
+
+                if (end == std::string_view::npos) {
+                    from++;
+                    continue;
                 }
 
-                column += res.length();
-                input.erase(0, 1);
+                DirectiveHead head = directiveHead(input, from, end);
 
-                return Token{
-                        .type = TokenType::BACK_TICK,
-                        .value = res,
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == '"') {
-                input.erase(0, 1);
-                std::string res = "\"";
-                index++;
-
-                size_t escape = 0;
-
-                while (true) {
-                    if (input.length() == 0)
-                        return std::nullopt;
-
-                    if (input[0] == '"') {
-                        if (escape != 0) {
-                            escape = 0;
-                            res += input[0];
-                        } else {
-                            res += "\"";
-                            break;
-                        }
-                    } else {
-                        if (input[0] == '\\') {
-                            res += '\\';
-                            escape++;
-                        } else {
-                            escape = 0;
-                            res += input[0];
-                        }
-                    }
+                if (head.name == name) {
+                    depth++;
+                } else if (head.name == "end" && head.rest == name) {
+                    if (depth == 0)
+                        return end;
 
-                    input.erase(0, 1);
+                    depth--;
+                } else if (toElse && depth == 0 && head.name == "else" && head.rest.empty()) {
+                    return end;
                 }
 
-                column += res.length();
-                input.erase(0, 1);
+                from = end;
+            }
 
-                return Token{
-                        .type = TokenType::STRING,
-                        .value = res,
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == 'f' && input[1] == 'n' && !std::isalpha(input[2])) {
-                input.erase(0, 2);
-                index++;
-                column += 2;
+            return std::string_view::npos;
+        }
+    }
 
-                return Token{
-                        .type = TokenType::FN,
-                        .value = "fn",
-                        .line = line,
-                        .column = column,
-                        .index = index
-                };
-            } else if (input[0] == 'r' && input[1] == 'e' && input[2] == 't' && !std::isalpha(input[3])) {
-                input.erase(0, 3);
-                index++;
-                column += 3;
+    class Lexer {
+        // The lexer never owns or mutates the source, it only walks a cursor
+        // over it. The caller has to keep the buffer alive while lexing.
+        std::string_view input;
+        size_t cursor = 0;
+        SymbolTable *symbols = nullptr;
+
+        [[nodiscard]] char peek(size_t offset = 0) const {
+            return cursor + offset < input.length() ? input[cursor + offset] : '\0';
+        }
+
+        Token make(TokenType type, size_t length) {
+            Token token{
+                    .type = type,
+                    .value = input.substr(cursor, length),
+                    .offset = cursor
+            };
+
+            cursor += length;
+            return token;
+        }
+
+        // Lexes `c` or `cc` into the single or double variant of a symbol.
+        Token pair(TokenType doubled, TokenType single) {
+            if (peek(1) == peek())
+                return make(doubled, 2);
+
+            return make(single, 1);
+        }
+
+        // Lexes `c` or `c=` into the plain or assigning variant of an operator.
+        Token assign(TokenType assigning, TokenType plain) {
+            if (peek(1) == '=')
+                return make(assigning, 2);
+
+            return make(plain, 1);
+        }
+
+        // Lexes a literal enclosed in `quote`, a backslash escapes the next character.
+        std::optional<Token> quoted(TokenType type, char quote) {
+            size_t end = scanQuoted(input, cursor + 1, quote);
+
+            while (end < input.length() && input[end] == '\\')
+                end = scanQuoted(input, end + 2, quote);
+
+            if (end >= input.length()) {
+                cursor = input.length();
+                return std::nullopt;
+            }
+
+            return make(type, end + 1 - cursor);
+        }
+
+        // Rejects up to `end`, or to the end of the input when it is npos.
+        std::nullopt_t reject(size_t end) {
+            cursor = std::min(end, input.length());
+            return std::nullopt;
+        }
+
+        // A block that is one token from its opening directive through the
+        // directive closing it, see detail::blockEnd().
+        std::optional<Token> block(TokenType type, size_t body, std::string_view name, bool toElse) {
+            size_t end = detail::blockEnd(input, body, name, toElse);
+
+            if (end == std::string_view::npos)
+                return reject(end);
+
+            return make(type, end - cursor);
+        }
+
+        // `#[...]`, evaluated as it is lexed so that no later stage sees the
+        // body of an inactive branch or of an `#[asm]` block:
+        // -- `#[if cond]` is an IF_DIRECTIVE when `cond` holds for the current
+        //    target, else an INACTIVE_BLOCK through its `#[else]` or `#[end if]`.
+        // -- `#[else]` only ever follows an active branch, since an inactive
+        //    one swallows it, so it is an INACTIVE_BLOCK through `#[end if]`.
+        // -- `#[asm]` is one ASM_BLOCK through `#[end asm]`, body untouched.
+        // -- Any other name, e.g. `#[kill]`, is a DIRECTIVE for the parser.
+        // A directive not closed on its own line, a malformed condition and a
+        // stray `#[end asm]` are rejected.
+        std::optional<Token> directive() {
+            size_t end = detail::directiveEnd(input, cursor);
+
+            if (end == std::string_view::npos)
+                return reject(scanLine(input, cursor));
+
+            detail::DirectiveHead head = detail::directiveHead(input, cursor, end);
+
+            if (head.name == "if") {
+                std::optional<bool> active = evaluateCondition(head.rest);
+
+                if (!active.has_value())
+                    return reject(end);
+
+                if (*active)
+                    return make(TokenType::IF_DIRECTIVE, end - cursor);
+
+                return block(TokenType::INACTIVE_BLOCK, end, "if", true);
+            }
+
+            if (head.name == "else" && head.rest.empty())
+                return block(TokenType::INACTIVE_BLOCK, end, "if", false);
+
+            if (head.name == "asm" && head.rest.empty())
+                return block(TokenType::ASM_BLOCK, end, "asm", false);
+
+            if (head.name == "end") {
+                if (head.rest != "if")
+                    return reject(end);
+
+                return make(TokenType::END_IF_DIRECTIVE, end - cursor);
+            }
 
+            return make(TokenType::DIRECTIVE, end - cursor);
+        }
+
+        std::optional<Token> number() {
+            NumberScan scan = scanNumber(input, cursor);
+
+            if (!scan.valid) {
+                cursor = scan.end;
+                return std::nullopt;
+            }
+
+            Token token = make(scan.kind, scan.end - cursor);
+            token.literal = scan.literal;
+            return token;
+        }
+
+        std::optional<Token> character() {
+            std::optional<Token> token = quoted(TokenType::CHAR_LIT, '\'');
+
+            if (!token.has_value())
+                return std::nullopt;
+
+            // The cursor is already past the literal, so a bad one is skipped whole
+            auto codePoint = decodeChar(token->value.substr(1, token->value.length() - 2));
+
+            if (!codePoint.has_value())
+                return std::nullopt;
+
+            token->literal.low = *codePoint;
+            token->literal.type = TokenType::CHAR;
+            return token;
+        }
+
+    public:
+        explicit Lexer(std::string_view input): input(input) {}
+
+        // Starts lexing at byte `from`. Tokens only depend on where they start,
+        // so lexing from any token boundary yields the same tokens from there on.
+        // Identifiers are interned into `symbols` as they are lexed when one is given.
+        Lexer(std::string_view input, size_t from, SymbolTable *symbols = nullptr)
+                : input(input), cursor(from), symbols(symbols) {}
+
+        // Returns nullopt for rejected bytes, with the cursor already past them:
+        // a malformed literal as a whole, or a run of bytes no token starts with.
+        std::optional<Token> next() {
+            if (cursor >= input.length())
                 return Token{
-                        .type = TokenType::RETURN,
-                        .value = "ret",
-                        .line = line,
-                        .column = column,
-                        .index = index
+                        TokenType::EOI,
+                        "EOI",
+                        cursor
                 };
+
+            switch (input[cursor]) {
+                case '\n':
+                    return make(TokenType::NEWLINE, 1);
+                case ' ':
+                    return make(TokenType::SPACE, scanRun(input, cursor + 1, ' ') - cursor);
+                case '\t':
+                    return make(TokenType::TAB, scanRun(input, cursor + 1, '\t') - cursor);
+                case '/': {
+                    if (peek(1) == '/') {
+                        return make(TokenType::COMMENT, scanLine(input, cursor + 2) - cursor);
+                    }
+
+                    return assign(TokenType::SLASH_EQ, TokenType::SLASH);
+                }
+                case '(':
+                    return pair(TokenType::D_L_PAREN, TokenType::L_PAREN);
+                case ')':
+                    return pair(TokenType::D_R_PAREN, TokenType::R_PAREN);
+                case '{':
+                    return pair(TokenType::D_L_BRACE, TokenType::L_BRACE);
+                case '}':
+                    return pair(TokenType::D_R_BRACE, TokenType::R_BRACE);
+                case '<':
+                    return pair(TokenType::D_L_ANGLE, TokenType::L_ANGLE);
+                case '>':
+                    return pair(TokenType::D_R_ANGLE, TokenType::R_ANGLE);
+                case '[':
+                    return pair(TokenType::D_L_BRACKET, TokenType::L_BRACKET);
+                case ']':
+                    return pair(TokenType::D_R_BRACKET, TokenType::R_BRACKET);
+                case '.':
+                    return pair(TokenType::D_DOT, TokenType::DOT);
+                case ':':
+                    return pair(TokenType::D_COLON, TokenType::COLON);
+                case ';':
+                    return make(TokenType::SEMICOLON, 1);
+                case ',':
+                    return make(TokenType::COMMA, 1);
+                case '#':
+                    if (peek(1) == '[')
+                        return directive();
+
+                    return make(TokenType::HASH, 1);
+                case '@':
+                    return make(TokenType::AT, 1);
+                case '&':
+                    return make(TokenType::AMPERSAND, 1);
+                case '-': {
+                    if (peek(1) == '>')
+                        return make(TokenType::RETURN_ARROW, 2);
+
+                    return assign(TokenType::SUBTRACT_EQ, TokenType::SUBTRACT);
+                }
+                case '+':
+                    return assign(TokenType::PLUS_EQ, TokenType::PLUS);
+                case '*':
+                    return assign(TokenType::START_EQ, TokenType::STAR);
+                case '=':
+                    return pair(TokenType::D_EQ, TokenType::EQ);
+                case '`':
+                    return quoted(TokenType::BACK_TICK, '`');
+                case '"':
+                    return quoted(TokenType::STRING, '"');
+                case '\'':
+                    return character();
+                default:
+                    break;
             }
 
+            if (detail::isDigit(input[cursor]))
+                return number();
+
             // Check if it's an identifier and matches the requirements as follows:
-            // -- Starts with an alpha character or underscore.
-            // -- Only contains alpha characters, underscores, and numbers.
-            
-            if (input[0] == '_' || std::isalpha(input[0])) {
-                std::string word;
-                
-                while (true) {
-                    if (input[0] != '_' && !std::isalpha(input[0]) && !std::isalnum(input[0]))
-                        break;
+            // -- Starts with an ASCII letter, an underscore or a non-ASCII code point.
+            // -- Only contains those and ASCII digits.
 
-                    word += input[0];
-                    column++;
+            if (detail::isIdentifierByte(input[cursor])) {
+                size_t end = scanIdentifier(input, cursor + 1);
+                std::string_view word = input.substr(cursor, end - cursor);
 
-                    input.erase(0, 1);
-                }
+                TokenType type = lookupKeyword(word).value_or(TokenType::IDENTIFIER);
+                Token token = make(type, word.length());
 
-                return Token {
-                    .type = TokenType::IDENTIFIER,
-                    .value = word,
-                    .line = line,
-                    .column = column,
-                    .index = index,
-                };
+                if (symbols != nullptr && type == TokenType::IDENTIFIER)
+                    token.payload = symbols->intern(word);
+
+                return token;
             }
 
-            column++;
-            input.erase(0, 1);
-            return std::nullopt;
-        }
+            // Resynchronise at the next byte that can start a token, so a run of
+            // garbage is rejected once instead of once per byte
+            do {
+                cursor++;
+            } while (cursor < input.length() && !detail::tokenStarts[static_cast<uint8_t>(input[cursor])]);
 
-        bool hasNext() {
-            return input.length() != 0;
+            return std::nullopt;
         }
 
-        [[nodiscard]] size_t getLine() const {
-            return line;
+        [[nodiscard]] bool hasNext() const {
+            return cursor < input.length();
         }
 
-        [[nodiscard]] size_t getColumn() const {
-            return column;
+        // Byte offset of the cursor, i.e. where the next token starts.
+        [[nodiscard]] size_t getIndex() const {
+            return cursor;
         }
     };
 }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "utf8.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xorLang {
+    struct Position {
+        size_t line;
+        size_t column;
+    };
+
+    // Byte offsets of the first character of every line in a source buffer.
+    // Positions are only needed for diagnostics, so they are resolved on demand
+    // by binary search instead of being tracked for every token. The source has
+    // to outlive the index.
+    class LineIndex {
+        std::string_view source;
+        std::vector<uint32_t> starts;
+
+    public:
+        explicit LineIndex(std::string_view source): source(source) {
+            starts.reserve(source.length() / 32 + 1);
+            starts.push_back(0);
+
+            const char *data = source.data();
+            size_t i = 0;
+
+#if defined(__SSE2__)
+            // Compare 16 bytes at a time and only visit the set bits of the mask.
+            const __m128i newline = _mm_set1_epi8('\n');
+
+            for (; i + 16 <= source.length(); i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+
+                while (mask != 0) {
+                    starts.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask) + 1));
+                    mask &= mask - 1;
+                }
+            }
+#endif
+
+            for (; i < source.length(); i++)
+                if (data[i] == '\n')
+                    starts.push_back(static_cast<uint32_t>(i + 1));
+        }
+
+        // 1-based line and column of the byte at `offset`, the column counted in
+        // code points.
+        [[nodiscard]] Position position(size_t offset) const {
+            auto it = std::upper_bound(starts.begin(), starts.end(), offset);
+            size_t line = static_cast<size_t>(it - starts.begin());
+            size_t start = starts[line - 1];
+
+            return Position{
+                    .line = line,
+                    .column = countCodePoints(source.substr(start, std::min(offset, source.length()) - start)) + 1
+            };
+        }
+
+        [[nodiscard]] size_t lineCount() const {
+            return starts.size();
+        }
+    };
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "keywords.h"
+#include "scan.h"
+#include "utf8.h"
+
+namespace xorLang {
+    // Value of a NUMBER, DECIMAL_NUMBER or CHAR_LIT token, decoded while lexing
+    // so no later stage has to parse literal text again. `type` is the suffix
+    // (INT_8BIT ... UINT_128BIT, FLOAT_32BIT, FLOAT_64BIT), INT_MAXBIT or
+    // FLOAT_MAXBIT for an unsuffixed number and CHAR for a char literal.
+    //
+    // Integers keep their magnitude in `low` and `high` (the sign is a separate
+    // unary operator), a char literal keeps its code point in `low`, and floats
+    // are correctly rounded to the suffix type and kept in `real`. `overflow` is
+    // set when the value does not fit the suffix type.
+    struct Literal {
+        uint64_t low = 0;
+        uint64_t high = 0;
+        double real = 0;
+        TokenType type = TokenType::INT_MAXBIT;
+        bool overflow = false;
+    };
+
+    // Token kinds that carry a Literal.
+    constexpr bool hasLiteral(TokenType type) {
+        return type == TokenType::NUMBER || type == TokenType::DECIMAL_NUMBER || type == TokenType::CHAR_LIT;
+    }
+
+    namespace detail {
+        __extension__ typedef unsigned __int128 UInt128;
+
+        inline constexpr UInt128 uint128Max = ~static_cast<UInt128>(0);
+
+        constexpr bool isDigit(char c) {
+            return static_cast<uint8_t>(c - '0') < 10;
+        }
+
+        constexpr int hexDigit(char c) {
+            if (isDigit(c))
+                return c - '0';
+
+            auto lower = static_cast<uint8_t>((c | 0x20) - 'a');
+            return lower < 6 ? lower + 10 : -1;
+        }
+
+        // True when all eight bytes of a little-endian load are ASCII digits.
+        constexpr bool isEightDigits(uint64_t bytes) {
+            return ((bytes & 0xF0F0F0F0F0F0F0F0) |
+                    (((bytes + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+        }
+
+        // Value of eight ASCII digits from a little-endian load, first digit most
+        // significant: pairs, then quads, then the whole word in three multiplies.
+        constexpr uint32_t parseEightDigits(uint64_t bytes) {
+            bytes -= 0x3030303030303030;
+            bytes = (bytes * 10) + (bytes >> 8);
+            bytes = (((bytes & 0x000000FF000000FF) * (100 + (1000000ull << 32))) +
+                     (((bytes >> 16) & 0x000000FF000000FF) * (1 + (10000ull << 32)))) >> 32;
+            return static_cast<uint32_t>(bytes);
+        }
+
+        // Largest magnitude a literal with suffix `type` can have. Signed types
+        // accept the magnitude of their minimum, so negating it reaches the minimum.
+        constexpr UInt128 suffixLimit(TokenType type) {
+            auto bits = [](unsigned width, bool isSigned) {
+                return isSigned ? static_cast<UInt128>(1) << (width - 1)
+                                : width == 128 ? uint128Max : (static_cast<UInt128>(1) << width) - 1;
+            };
+
+            switch (type) {
+                case TokenType::INT_8BIT:
+                    return bits(8, true);
+                case TokenType::INT_16BIT:
+                    return bits(16, true);
+                case TokenType::INT_32BIT:
+                    return bits(32, true);
+                case TokenType::INT_64BIT:
+                    return bits(64, true);
+                case TokenType::INT_128BIT:
+                    return bits(128, true);
+                case TokenType::UINT_8BIT:
+                    return bits(8, false);
+                case TokenType::UINT_16BIT:
+                    return bits(16, false);
+                case TokenType::UINT_32BIT:
+                    return bits(32, false);
+                case TokenType::UINT_64BIT:
+                    return bits(64, false);
+                default:
+                    return uint128Max;
+            }
+        }
+
+        constexpr bool isIntegerSuffix(TokenType type) {
+            return type >= TokenType::INT_8BIT && type <= TokenType::UINT_128BIT;
+        }
+
+        constexpr bool isFloatSuffix(TokenType type) {
+            return type == TokenType::FLOAT_32BIT || type == TokenType::FLOAT_64BIT;
+        }
+
+        // Correctly rounded conversion of decimal text with '_' separators.
+        inline void convertFloat(std::string_view text, Literal &literal) {
+            char stack[64];
+            std::string heap;
+            char *digits = stack;
+
+            if (text.length() > sizeof(stack)) {
+                heap.resize(text.length());
+                digits = heap.data();
+            }
+
+            size_t length = 0;
+
+            for (char c : text)
+                if (c != '_')
+                    digits[length++] = c;
+
+            bool single = literal.type == TokenType::FLOAT_32BIT;
+            std::from_chars_result result{};
+
+            if (single) {
+                float value = 0;
+                result = std::from_chars(digits, digits + length, value);
+                literal.real = value;
+            } else {
+                result = std::from_chars(digits, digits + length, literal.real);
+            }
+
+            // from_chars leaves the value alone when it is out of range, strtod
+            // gives the infinity or the zero it rounds to.
+            if (result.ec == std::errc::result_out_of_range) {
+                std::string terminated(digits, length);
+
+                literal.real = single ? std::strtof(terminated.c_str(), nullptr) : std::strtod(terminated.c_str(), nullptr);
+                literal.overflow = std::isinf(literal.real);
+            }
+        }
+    }
+
+    struct NumberScan {
+        size_t end;
+        TokenType kind;
+        Literal literal;
+        bool valid;
+    };
+
+    // Scans and decodes the number starting with the digit at `from`:
+    //
+    //   decimal  123  1_000_000  1.5  2e10  6.02e+23
+    //   hex      0xFF_FF    binary  0b1010
+    //
+    // optionally followed by a suffix i8 ... u128, f32 or f64. A fraction needs a
+    // digit after the dot so `1..2` stays a range and `1.abs` a member access.
+    // Any identifier characters right after the digits belong to the suffix, an
+    // unknown suffix, an empty exponent or a `_` that is not between two digits
+    // makes the whole run invalid. The scan
+    // looks at most two bytes past the end of the number.
+    inline NumberScan scanNumber(std::string_view input, size_t from) {
+        auto at = [&](size_t i) {
+            return i < input.length() ? input[i] : '\0';
+        };
+
+        NumberScan scan{.end = from, .kind = TokenType::NUMBER, .literal = {}, .valid = true};
+        detail::UInt128 value = 0;
+        bool overflow = false;
+        size_t pos = from;
+        unsigned base = 10;
+
+        if (at(pos) == '0' && (at(pos + 1) | 0x20) == 'x')
+            base = 16;
+        else if (at(pos) == '0' && (at(pos + 1) | 0x20) == 'b')
+            base = 2;
+
+        if (base != 10)
+            pos += 2;
+
+        auto isDigitOf = [&](char c) {
+            return base == 16 ? detail::hexDigit(c) >= 0 : base == 2 ? c == '0' || c == '1' : detail::isDigit(c);
+        };
+
+        // A `_` only separates digits, as in 1_000: `1_`, `1__0` and `0x_FF`
+        // are invalid.
+        auto separates = [&](size_t i) {
+            return isDigitOf(at(i - 1)) && isDigitOf(at(i + 1));
+        };
+
+        size_t digits = 0;
+
+        if (base == 10) {
+            while (true) {
+                if constexpr (std::endian::native == std::endian::little) {
+                    while (pos + 8 <= input.length()) {
+                        uint64_t bytes;
+                        std::memcpy(&bytes, input.data() + pos, 8);
+
+                        if (!detail::isEightDigits(bytes))
+                            break;
+
+                        uint32_t chunk = detail::parseEightDigits(bytes);
+
+                        overflow |= value > (detail::uint128Max - chunk) / 100000000;
+                        value = value * 100000000 + chunk;
+                        digits += 8;
+                        pos += 8;
+                    }
+                }
+
+                char c = at(pos);
+
+                if (detail::isDigit(c)) {
+                    auto digit = static_cast<unsigned>(c - '0');
+
+                    overflow |= value > (detail::uint128Max - digit) / 10;
+                    value = value * 10 + digit;
+                    digits++;
+                } else if (c == '_') {
+                    scan.valid &= separates(pos);
+                } else {
+                    break;
+                }
+
+                pos++;
+            }
+        } else {
+            unsigned shift = base == 16 ? 4 : 1;
+
+            while (true) {
+                char c = at(pos);
+                int digit = base == 16 ? detail::hexDigit(c) : (c == '0' || c == '1' ? c - '0' : -1);
+
+                if (digit >= 0) {
+                    overflow |= (value >> (128 - shift)) != 0;
+                    value = (value << shift) | static_cast<unsigned>(digit);
+                    digits++;
+                } else if (c == '_') {
+                    scan.valid &= separates(pos);
+                } else {
+                    break;
+                }
+
+                pos++;
+            }
+        }
+
+        bool isFloat = false;
+
+        if (base == 10 && at(pos) == '.' && detail::isDigit(at(pos + 1))) {
+            isFloat = true;
+            pos++;
+
+            for (; detail::isDigit(at(pos)) || at(pos) == '_'; pos++)
+                scan.valid &= at(pos) != '_' || separates(pos);
+        }
+
+        if (base == 10 && (at(pos) | 0x20) == 'e') {
+            isFloat = true;
+            pos++;
+
+            if (at(pos) == '+' || at(pos) == '-')
+                pos++;
+
+            size_t exponent = pos;
+
+            for (; detail::isDigit(at(pos)) || at(pos) == '_'; pos++)
+                scan.valid &= at(pos) != '_' || separates(pos);
+
+            scan.valid &= pos > exponent;
+        }
+
+        size_t numberEnd = pos;
+        scan.literal.type = isFloat ? TokenType::FLOAT_MAXBIT : TokenType::INT_MAXBIT;
+
+        if (detail::isIdentifierByte(at(pos))) {
+            pos = scanIdentifier(input, pos);
+            auto suffix = lookupKeyword(input.substr(numberEnd, pos - numberEnd));
+
+            if (suffix.has_value() && detail::isFloatSuffix(*suffix))
+                scan.valid &= base == 10;
+            else if (suffix.has_value() && detail::isIntegerSuffix(*suffix))
+                scan.valid &= !isFloat;
+            else
+                scan.valid = false;
+
+            if (suffix.has_value())
+                scan.literal.type = *suffix;
+        }
+
+        scan.end = pos;
+        scan.valid &= digits > 0;
+
+        if (!scan.valid)
+            return scan;
+
+        if (isFloat || detail::isFloatSuffix(scan.literal.type)) {
+            scan.kind = TokenType::DECIMAL_NUMBER;
+            detail::convertFloat(input.substr(from, numberEnd - from), scan.literal);
+        } else {
+            scan.literal.low = static_cast<uint64_t>(value);
+            scan.literal.high = static_cast<uint64_t>(value >> 64);
+            scan.literal.overflow = overflow || value > detail::suffixLimit(scan.literal.type);
+        }
+
+        return scan;
+    }
+
+    // Code point of the body of a char literal (the text between the quotes):
+    // one well-formed UTF-8 character or one of the escapes \n \t \r \0 \\ \' \".
+    inline std::optional<uint32_t> decodeChar(std::string_view body) {
+        if (body.empty())
+            return std::nullopt;
+
+        if (body[0] == '\\') {
+            if (body.length() != 2)
+                return std::nullopt;
+
+            switch (body[1]) {
+                case 'n':
+                    return '\n';
+                case 't':
+                    return '\t';
+                case 'r':
+                    return '\r';
+                case '0':
+                    return '\0';
+                case '\\':
+                case '\'':
+                case '"':
+                    return static_cast<uint32_t>(body[1]);
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        const auto *bytes = reinterpret_cast<const uint8_t *>(body.data());
+        size_t length = detail::utf8::sequenceLength(bytes, body.length(), 0);
+
+        if (length == 0 || body.length() != length)
+            return std::nullopt;
+
+        uint32_t codePoint = length == 1 ? bytes[0] : bytes[0] & (0x7F >> length);
+
+        for (size_t i = 1; i < length; i++)
+            codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+
+        return codePoint;
+    }
+}
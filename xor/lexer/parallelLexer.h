@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include "tokenBuffer.h"
+#include "../util/threadPool.h"
+
+namespace xorLang {
+    // Lexes one large buffer on `pool` and returns exactly the tokens lexAll()
+    // would. The buffer is cut into chunks that are lexed speculatively, as if a
+    // token started at every cut. A chunk may really begin inside a string,
+    // backtick literal or comment, so the chunks are then stitched in order: the
+    // true end of the previous chunk is looked up among the chunk's token starts,
+    // and only when it is not one of them is the chunk re-lexed serially from
+    // there until it meets one. From that point the speculative tokens are exact.
+    // Waits on the whole pool, so it must not be called from one of its tasks.
+    // Identifiers lexed speculatively past a true boundary may add a few unused
+    // names to `symbols`.
+    inline TokenBuffer lexParallel(std::string_view source, ThreadPool &pool, SymbolTable *symbols = nullptr,
+                                   size_t chunkSize = 1 << 20) {
+        size_t chunks = (source.length() + chunkSize - 1) / std::max<size_t>(chunkSize, 1);
+
+        if (chunks <= 1 || pool.size() <= 1)
+            return lexAll(source, symbols);
+
+        std::vector<TokenBuffer> parts(chunks);
+
+        for (size_t k = 0; k < chunks; k++) {
+            pool.submit([&, k] {
+                TokenBuffer &part = parts[k];
+                size_t begin = k * chunkSize;
+
+                part.source = source;
+                part.reserve(chunkSize / 4 + 1);
+                lexRange(part, begin, std::min(begin + chunkSize, source.length()), symbols);
+            });
+        }
+
+        pool.wait();
+
+        TokenBuffer buffer;
+        buffer.source = source;
+        buffer.reserve(source.length() / 4 + 1);
+        buffer.append(parts[0], 0);
+
+        for (size_t k = 1; k < chunks; k++) {
+            const TokenBuffer &part = parts[k];
+            size_t chunkEnd = std::min((k + 1) * chunkSize, source.length());
+            size_t position = buffer.end();
+
+            // A token of an earlier chunk already covers this whole chunk
+            if (position >= chunkEnd)
+                continue;
+
+            auto synced = std::lower_bound(part.offsets.begin(), part.offsets.end(), position);
+            Lexer lexer(source, position, symbols);
+
+            while (!(synced != part.offsets.end() && *synced == position) && position < chunkEnd) {
+                auto token = lexer.next();
+
+                if (token.has_value())
+                    buffer.push(*token);
+                else
+                    buffer.push(TokenType::INVALID, position, lexer.getIndex() - position);
+
+                position = lexer.getIndex();
+                synced = std::lower_bound(synced, part.offsets.end(), position);
+            }
+
+            if (synced != part.offsets.end() && *synced == position)
+                buffer.append(part, static_cast<size_t>(synced - part.offsets.begin()));
+        }
+
+        buffer.push(TokenType::EOI, source.length(), 0);
+        return buffer;
+    }
+}
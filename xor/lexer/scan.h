@@ -0,0 +1,424 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string_view>
+
+#if defined(__x86_64__)
+#define XOR_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Scanners for the long runs of the lexer: identifiers, whitespace, comment
+// bodies, literal bodies and the bodies of skipped directive blocks. Each one
+// returns the offset of the first byte at or after `from` that ends the run,
+// or `size` when the run reaches the end. The widest kernel the CPU supports
+// is picked once at startup; XOR_SIMD=scalar, sse2, avx2 or avx512 forces
+// one, and every kernel produces the same offsets.
+
+namespace xorLang {
+    enum class ScanIsa {
+        SCALAR, SSE2, AVX2, AVX512
+    };
+
+    namespace detail {
+        struct ScanKernels {
+            ScanIsa isa;
+            size_t (*identifier)(const char *data, size_t size, size_t from);
+            size_t (*run)(const char *data, size_t size, size_t from, char c);
+            size_t (*line)(const char *data, size_t size, size_t from);
+            size_t (*quoted)(const char *data, size_t size, size_t from, char quote);
+            size_t (*find)(const char *data, size_t size, size_t from, char c);
+        };
+
+        // Every byte of a non-ASCII code point counts as an identifier byte, so
+        // identifiers may use any script. Sources are validated as UTF-8 first.
+        inline bool isIdentifierByte(char c) {
+            auto b = static_cast<uint8_t>(c);
+            return b == '_' || static_cast<uint8_t>((b | 0x20) - 'a') < 26 || static_cast<uint8_t>(b - '0') < 10 ||
+                   b >= 0x80;
+        }
+
+        namespace scalar {
+            inline size_t identifier(const char *data, size_t size, size_t from) {
+                while (from < size && isIdentifierByte(data[from]))
+                    from++;
+
+                return from;
+            }
+
+            inline size_t run(const char *data, size_t size, size_t from, char c) {
+                while (from < size && data[from] == c)
+                    from++;
+
+                return from;
+            }
+
+            inline size_t line(const char *data, size_t size, size_t from) {
+                while (from < size && data[from] != '\n')
+                    from++;
+
+                return from;
+            }
+
+            inline size_t quoted(const char *data, size_t size, size_t from, char quote) {
+                while (from < size && data[from] != quote && data[from] != '\\')
+                    from++;
+
+                return from;
+            }
+
+            inline size_t find(const char *data, size_t size, size_t from, char c) {
+                while (from < size && data[from] != c)
+                    from++;
+
+                return from;
+            }
+        }
+
+#if defined(XOR_SCAN_X86)
+        // Each vector kernel builds a mask of the bytes that end the run, jumps to
+        // its lowest set bit, and hands the tail shorter than a vector to the
+        // scalar kernel so no load ever crosses the end of the buffer.
+
+        namespace sse2 {
+            inline __m128i inRange(__m128i v, char low, char high) {
+                __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(low));
+                __m128i span = _mm_set1_epi8(static_cast<char>(high - low));
+                return _mm_cmpeq_epi8(_mm_min_epu8(shifted, span), shifted);
+            }
+
+            inline uint32_t identifierMask(__m128i v) {
+                __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+                __m128i word = _mm_or_si128(inRange(lower, 'a', 'z'), inRange(v, '0', '9'));
+                word = _mm_or_si128(word, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+                return ~static_cast<uint32_t>(_mm_movemask_epi8(word) | _mm_movemask_epi8(v)) & 0xFFFF;
+            }
+
+            inline size_t identifier(const char *data, size_t size, size_t from) {
+                for (; from + 16 <= size; from += 16) {
+                    uint32_t mask = identifierMask(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from)));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return scalar::identifier(data, size, from);
+            }
+
+            inline size_t run(const char *data, size_t size, size_t from, char c) {
+                const __m128i needle = _mm_set1_epi8(c);
+
+                for (; from + 16 <= size; from += 16) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+                    uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle))) & 0xFFFF;
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return scalar::run(data, size, from, c);
+            }
+
+            inline size_t line(const char *data, size_t size, size_t from) {
+                const __m128i newline = _mm_set1_epi8('\n');
+
+                for (; from + 16 <= size; from += 16) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+                    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return scalar::line(data, size, from);
+            }
+
+            inline size_t quoted(const char *data, size_t size, size_t from, char quote) {
+                const __m128i close = _mm_set1_epi8(quote);
+                const __m128i escape = _mm_set1_epi8('\\');
+
+                for (; from + 16 <= size; from += 16) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+                    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                            _mm_or_si128(_mm_cmpeq_epi8(v, close), _mm_cmpeq_epi8(v, escape))));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return scalar::quoted(data, size, from, quote);
+            }
+
+            inline size_t find(const char *data, size_t size, size_t from, char c) {
+                const __m128i needle = _mm_set1_epi8(c);
+
+                for (; from + 16 <= size; from += 16) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+                    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return scalar::find(data, size, from, c);
+            }
+        }
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+        namespace avx2 {
+            inline __m256i inRange(__m256i v, char low, char high) {
+                __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(low));
+                __m256i span = _mm256_set1_epi8(static_cast<char>(high - low));
+                return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, span), shifted);
+            }
+
+            inline size_t identifier(const char *data, size_t size, size_t from) {
+                for (; from + 32 <= size; from += 32) {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+                    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+                    __m256i word = _mm256_or_si256(inRange(lower, 'a', 'z'), inRange(v, '0', '9'));
+                    word = _mm256_or_si256(word, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+                    auto mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(word) | _mm256_movemask_epi8(v));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return sse2::identifier(data, size, from);
+            }
+
+            inline size_t run(const char *data, size_t size, size_t from, char c) {
+                const __m256i needle = _mm256_set1_epi8(c);
+
+                for (; from + 32 <= size; from += 32) {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+                    auto mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return sse2::run(data, size, from, c);
+            }
+
+            inline size_t line(const char *data, size_t size, size_t from) {
+                const __m256i newline = _mm256_set1_epi8('\n');
+
+                for (; from + 32 <= size; from += 32) {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+                    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return sse2::line(data, size, from);
+            }
+
+            inline size_t quoted(const char *data, size_t size, size_t from, char quote) {
+                const __m256i close = _mm256_set1_epi8(quote);
+                const __m256i escape = _mm256_set1_epi8('\\');
+
+                for (; from + 32 <= size; from += 32) {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+                    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+                            _mm256_or_si256(_mm256_cmpeq_epi8(v, close), _mm256_cmpeq_epi8(v, escape))));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return sse2::quoted(data, size, from, quote);
+            }
+
+            inline size_t find(const char *data, size_t size, size_t from, char c) {
+                const __m256i needle = _mm256_set1_epi8(c);
+
+                for (; from + 32 <= size; from += 32) {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+                    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+
+                    if (mask != 0)
+                        return from + __builtin_ctz(mask);
+                }
+
+                return sse2::find(data, size, from, c);
+            }
+        }
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+        namespace avx512 {
+            inline __mmask64 inRange(__m512i v, char low, char high) {
+                __m512i shifted = _mm512_sub_epi8(v, _mm512_set1_epi8(low));
+                return _mm512_cmple_epu8_mask(shifted, _mm512_set1_epi8(static_cast<char>(high - low)));
+            }
+
+            inline size_t identifier(const char *data, size_t size, size_t from) {
+                for (; from + 64 <= size; from += 64) {
+                    __m512i v = _mm512_loadu_si512(data + from);
+                    __m512i lower = _mm512_or_si512(v, _mm512_set1_epi8(0x20));
+                    __mmask64 word = inRange(lower, 'a', 'z') | inRange(v, '0', '9') |
+                                     _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('_')) | _mm512_movepi8_mask(v);
+                    uint64_t mask = ~static_cast<uint64_t>(word);
+
+                    if (mask != 0)
+                        return from + __builtin_ctzll(mask);
+                }
+
+                return avx2::identifier(data, size, from);
+            }
+
+            inline size_t run(const char *data, size_t size, size_t from, char c) {
+                const __m512i needle = _mm512_set1_epi8(c);
+
+                for (; from + 64 <= size; from += 64) {
+                    uint64_t mask = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(data + from), needle);
+
+                    if (mask != 0)
+                        return from + __builtin_ctzll(mask);
+                }
+
+                return avx2::run(data, size, from, c);
+            }
+
+            inline size_t line(const char *data, size_t size, size_t from) {
+                const __m512i newline = _mm512_set1_epi8('\n');
+
+                for (; from + 64 <= size; from += 64) {
+                    uint64_t mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + from), newline);
+
+                    if (mask != 0)
+                        return from + __builtin_ctzll(mask);
+                }
+
+                return avx2::line(data, size, from);
+            }
+
+            inline size_t quoted(const char *data, size_t size, size_t from, char quote) {
+                const __m512i close = _mm512_set1_epi8(quote);
+                const __m512i escape = _mm512_set1_epi8('\\');
+
+                for (; from + 64 <= size; from += 64) {
+                    __m512i v = _mm512_loadu_si512(data + from);
+                    uint64_t mask = _mm512_cmpeq_epi8_mask(v, close) | _mm512_cmpeq_epi8_mask(v, escape);
+
+                    if (mask != 0)
+                        return from + __builtin_ctzll(mask);
+                }
+
+                return avx2::quoted(data, size, from, quote);
+            }
+
+            inline size_t find(const char *data, size_t size, size_t from, char c) {
+                const __m512i needle = _mm512_set1_epi8(c);
+
+                for (; from + 64 <= size; from += 64) {
+                    uint64_t mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + from), needle);
+
+                    if (mask != 0)
+                        return from + __builtin_ctzll(mask);
+                }
+
+                return avx2::find(data, size, from, c);
+            }
+        }
+#pragma GCC pop_options
+#endif
+
+        // The kernels for `isa`, nullopt when the CPU lacks it.
+        inline std::optional<ScanKernels> scanKernelsFor(ScanIsa isa) {
+#if defined(XOR_SCAN_X86)
+            __builtin_cpu_init();
+#endif
+
+            switch (isa) {
+                case ScanIsa::SCALAR:
+                    return ScanKernels{
+                            ScanIsa::SCALAR, scalar::identifier, scalar::run, scalar::line, scalar::quoted, scalar::find
+                    };
+#if defined(XOR_SCAN_X86)
+                case ScanIsa::SSE2:
+                    return ScanKernels{ScanIsa::SSE2, sse2::identifier, sse2::run, sse2::line, sse2::quoted, sse2::find};
+                case ScanIsa::AVX2:
+                    if (!__builtin_cpu_supports("avx2"))
+                        break;
+
+                    return ScanKernels{ScanIsa::AVX2, avx2::identifier, avx2::run, avx2::line, avx2::quoted, avx2::find};
+                case ScanIsa::AVX512:
+                    if (!__builtin_cpu_supports("avx512bw"))
+                        break;
+
+                    return ScanKernels{
+                            ScanIsa::AVX512, avx512::identifier, avx512::run, avx512::line, avx512::quoted, avx512::find
+                    };
+#else
+                default:
+                    break;
+#endif
+            }
+
+            return std::nullopt;
+        }
+
+        inline ScanKernels selectScanKernels() {
+            const char *forced = std::getenv("XOR_SIMD");
+            std::string_view wanted = forced != nullptr ? forced : "";
+            bool any = wanted.empty();
+
+            if (wanted != "scalar") {
+                if (any || wanted == "avx512")
+                    if (auto kernels = scanKernelsFor(ScanIsa::AVX512))
+                        return *kernels;
+
+                if (any || wanted == "avx2" || wanted == "avx512")
+                    if (auto kernels = scanKernelsFor(ScanIsa::AVX2))
+                        return *kernels;
+
+                if (auto kernels = scanKernelsFor(ScanIsa::SSE2))
+                    return *kernels;
+            }
+
+            return *scanKernelsFor(ScanIsa::SCALAR);
+        }
+
+        inline const ScanKernels &scanKernels() {
+            static const ScanKernels kernels = selectScanKernels();
+            return kernels;
+        }
+    }
+
+    [[nodiscard]] inline ScanIsa scanIsa() {
+        return detail::scanKernels().isa;
+    }
+
+    // End of the identifier characters [A-Za-z0-9_] and non-ASCII bytes starting at `from`.
+    inline size_t scanIdentifier(std::string_view input, size_t from) {
+        return detail::scanKernels().identifier(input.data(), input.length(), from);
+    }
+
+    // End of the run of `c` starting at `from`.
+    inline size_t scanRun(std::string_view input, size_t from, char c) {
+        return detail::scanKernels().run(input.data(), input.length(), from, c);
+    }
+
+    // Offset of the next newline, used for comment bodies.
+    inline size_t scanLine(std::string_view input, size_t from) {
+        return detail::scanKernels().line(input.data(), input.length(), from);
+    }
+
+    // Offset of the next `quote` or backslash inside a literal body.
+    inline size_t scanQuoted(std::string_view input, size_t from, char quote) {
+        return detail::scanKernels().quoted(input.data(), input.length(), from, quote);
+    }
+
+    // Offset of the next `c`, used to look for the directive closing a block
+    // whose body is never lexed.
+    inline size_t scanFor(std::string_view input, size_t from, char c) {
+        return detail::scanKernels().find(input.data(), input.length(), from, c);
+    }
+}
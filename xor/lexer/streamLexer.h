@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+#include "lexer.h"
+#include "lineIndex.h"
+
+namespace xorLang {
+    // Lexes any file descriptor (a pipe, stdin, a socket) through a fixed-size
+    // buffer that is refilled as tokens are consumed, so memory stays bounded by
+    // the buffer size rather than the input size.
+    //
+    // A token ending within two bytes of the end of the buffered window might
+    // continue in, or depend on, data not read yet, so it is lexed again once
+    // more data is in: the consumed prefix is dropped, the rest moved to the
+    // front and the free space refilled. It is only lexed again once the window
+    // from its start has doubled, so a long token arriving in many small reads
+    // costs linear time rather than a rescan per read.
+    // Only a single token longer than the whole buffer makes the buffer grow,
+    // and a token reaching `maxToken` bytes is cut off there as an INVALID
+    // token, so the buffer never grows past about twice that.
+    //
+    // Token offsets are absolute, but token values point into the buffer and are
+    // only valid until the next call to next().
+    class StreamLexer {
+        int fd;
+        std::vector<char> buffer;
+        SymbolTable *symbols;
+        size_t maxToken;
+
+        // Absolute offset of buffer[0], start of the unconsumed bytes, bytes filled
+        size_t base = 0;
+        size_t begin = 0;
+        size_t filled = 0;
+        bool eof = false;
+
+        // Lines and the code points of the current line are counted up to
+        // `counted` for position()
+        size_t counted = 0;
+        size_t line = 1;
+        size_t column = 1;
+
+        void count(size_t until) {
+            for (size_t i = counted; i < until; i++) {
+                char c = buffer[i - base];
+
+                if (c == '\n') {
+                    line++;
+                    column = 1;
+                } else if (!detail::utf8::isContinuation(static_cast<uint8_t>(c))) {
+                    column++;
+                }
+            }
+
+            counted = until;
+        }
+
+        // Makes room and reads more input; returns false at end of input.
+        bool refill() {
+            if (eof)
+                return false;
+
+            if (filled == buffer.size()) {
+                if (begin > 0) {
+                    count(base + begin);
+                    std::memmove(buffer.data(), buffer.data() + begin, filled - begin);
+                    base += begin;
+                    filled -= begin;
+                    begin = 0;
+                } else {
+                    buffer.resize(buffer.size() * 2);
+                }
+            }
+
+            while (true) {
+                ssize_t got = ::read(fd, buffer.data() + filled, buffer.size() - filled);
+
+                if (got < 0 && errno == EINTR)
+                    continue;
+
+                if (got <= 0) {
+                    eof = true;
+                    return false;
+                }
+
+                filled += static_cast<size_t>(got);
+                return true;
+            }
+        }
+
+    public:
+        explicit StreamLexer(int fd, size_t capacity = 64 * 1024, SymbolTable *symbols = nullptr,
+                             size_t maxToken = 16 * 1024 * 1024)
+                : fd(fd), buffer(std::max<size_t>(capacity, 16)), symbols(symbols), maxToken(std::max<size_t>(maxToken, 16)) {}
+
+        std::optional<Token> next() {
+            while (true) {
+                if (begin == filled && !refill())
+                    return Token{TokenType::EOI, "EOI", base + begin};
+
+                Lexer lexer(std::string_view(buffer.data(), filled), begin, symbols);
+                std::optional<Token> token = lexer.next();
+
+                if (lexer.getIndex() + 1 >= filled && !eof) {
+                    size_t pending = filled - begin;
+
+                    if (pending >= maxToken) {
+                        begin += maxToken;
+                        return std::nullopt;
+                    }
+
+                    // Compacting keeps `filled - begin`, growing the buffer only
+                    // happens once it is full
+                    while (refill() && filled - begin < 2 * pending && filled < buffer.size()) {}
+
+                    continue;
+                }
+
+                begin = lexer.getIndex();
+
+                if (token.has_value())
+                    token->offset += base;
+
+                return token;
+            }
+        }
+
+        bool hasNext() {
+            return begin < filled || refill();
+        }
+
+        // Absolute offset of the next token.
+        [[nodiscard]] size_t getIndex() const {
+            return base + begin;
+        }
+
+        // The bytes from absolute offset `from` up to the cursor, e.g. the bytes of
+        // a token just rejected by next(). Valid until the next call to next().
+        [[nodiscard]] std::string_view text(size_t from) const {
+            return {buffer.data() + (from - base), base + begin - from};
+        }
+
+        // Line and column (in code points) of an offset that is still buffered.
+        // Lines are only counted forward, so offsets have to be asked for in
+        // increasing order.
+        [[nodiscard]] Position position(size_t offset) {
+            count(offset);
+
+            return Position{
+                    .line = line,
+                    .column = column
+            };
+        }
+    };
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace xorLang {
+    // The platform `#[if ...]` conditions are evaluated for. Conditions
+    // compare its fields by name, e.g. `#[if os == "Linux" && arch != "aarch64"]`.
+    struct Target {
+        std::string os;
+        std::string arch;
+    };
+
+    inline Target hostTarget() {
+        Target target;
+
+#if defined(__linux__)
+        target.os = "Linux";
+#elif defined(__APPLE__)
+        target.os = "macOS";
+#elif defined(_WIN32)
+        target.os = "Windows";
+#elif defined(__FreeBSD__)
+        target.os = "FreeBSD";
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+        target.arch = "x86_64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        target.arch = "aarch64";
+#elif defined(__riscv) && __riscv_xlen == 64
+        target.arch = "riscv64";
+#endif
+
+        return target;
+    }
+
+    namespace detail {
+        inline Target &targetSlot() {
+            static Target target = hostTarget();
+            return target;
+        }
+    }
+
+    // The target of this run, the host unless selectTarget() said otherwise.
+    inline const Target &currentTarget() {
+        return detail::targetSlot();
+    }
+
+    // Lexers read the target without locking, so it has to be selected
+    // before the first source is lexed.
+    inline void selectTarget(Target target) {
+        detail::targetSlot() = std::move(target);
+    }
+
+    namespace detail {
+        // condition := all ('||' all)*
+        // all       := one ('&&' one)*
+        // one       := '!' one | '(' condition ')' | 'true' | 'false' | key ('==' | '!=') "value"
+        class ConditionParser {
+            std::string_view text;
+            const Target &target;
+            size_t at = 0;
+            bool failed = false;
+            // Open parentheses; a condition nested deeper is malformed
+            static constexpr size_t maxDepth = 64;
+            size_t depth = 0;
+
+            void skipSpaces() {
+                while (at < text.length() && (text[at] == ' ' || text[at] == '\t'))
+                    at++;
+            }
+
+            bool accept(std::string_view token) {
+                skipSpaces();
+
+                if (text.substr(at, token.length()) != token)
+                    return false;
+
+                at += token.length();
+                return true;
+            }
+
+            std::string_view word() {
+                skipSpaces();
+                size_t start = at;
+
+                while (at < text.length() && (text[at] == '_' || static_cast<unsigned char>((text[at] | 0x20) - 'a') < 26 ||
+                                              static_cast<unsigned char>(text[at] - '0') < 10))
+                    at++;
+
+                return text.substr(start, at - start);
+            }
+
+            std::optional<std::string_view> field(std::string_view key) const {
+                if (key == "os")
+                    return target.os;
+                else if (key == "arch")
+                    return target.arch;
+
+                return std::nullopt;
+            }
+
+            // `!` may be repeated any number of times.
+            bool one() {
+                bool negated = false;
+
+                while (accept("!"))
+                    negated = !negated;
+
+                return term() != negated;
+            }
+
+            bool term() {
+                if (accept("(")) {
+                    if (++depth > maxDepth) {
+                        failed = true;
+                        return false;
+                    }
+
+                    bool value = condition();
+                    failed |= !accept(")");
+                    depth--;
+                    return value;
+                }
+
+                std::string_view key = word();
+
+                if (key == "true" || key == "false")
+                    return key == "true";
+
+                std::optional<std::string_view> actual = field(key);
+                bool equal = accept("==");
+
+                if (!actual.has_value() || (!equal && !accept("!=")) || !accept("\"")) {
+                    failed = true;
+                    return false;
+                }
+
+                size_t close = text.find('"', at);
+
+                if (close == std::string_view::npos) {
+                    failed = true;
+                    return false;
+                }
+
+                std::string_view expected = text.substr(at, close - at);
+                at = close + 1;
+                return (*actual == expected) == equal;
+            }
+
+            bool all() {
+                bool value = one();
+
+                while (!failed && accept("&&"))
+                    value &= one();
+
+                return value;
+            }
+
+            bool condition() {
+                bool value = all();
+
+                while (!failed && accept("||"))
+                    value |= all();
+
+                return value;
+            }
+
+        public:
+            ConditionParser(std::string_view text, const Target &target): text(text), target(target) {}
+
+            std::optional<bool> parse() {
+                bool value = condition();
+                skipSpaces();
+
+                if (failed || at != text.length())
+                    return std::nullopt;
+
+                return value;
+            }
+        };
+    }
+
+    // Whether the condition of an `#[if ...]` holds for `target`; nullopt when
+    // it is malformed or names a key other than `os` and `arch`.
+    inline std::optional<bool> evaluateCondition(std::string_view condition, const Target &target = currentTarget()) {
+        return detail::ConditionParser(condition, target).parse();
+    }
+}
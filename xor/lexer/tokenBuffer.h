@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "lexer.h"
+
+namespace xorLang {
+    // One array of a TokenBuffer: a vector, or a read-only view of an array
+    // that `owner` keeps alive (a mapped cache entry), copied into the vector
+    // by the first change. Reads never copy; changes go through the mutators
+    // or edit().
+    template<typename T>
+    class TokenColumn {
+        std::vector<T> items;
+        const T *view = nullptr;
+        size_t viewSize = 0;
+        std::shared_ptr<const void> owner;
+
+    public:
+        TokenColumn() = default;
+
+        TokenColumn(const T *view, size_t size, std::shared_ptr<const void> owner)
+                : view(view), viewSize(size), owner(std::move(owner)) {}
+
+        // The items as a vector to change, copying a view first.
+        std::vector<T> &edit() {
+            if (view != nullptr) {
+                items.assign(view, view + viewSize);
+                view = nullptr;
+                viewSize = 0;
+                owner.reset();
+            }
+
+            return items;
+        }
+
+        [[nodiscard]] bool mapped() const {
+            return view != nullptr;
+        }
+
+        [[nodiscard]] const T *data() const {
+            return view != nullptr ? view : items.data();
+        }
+
+        [[nodiscard]] size_t size() const {
+            return view != nullptr ? viewSize : items.size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return size() == 0;
+        }
+
+        [[nodiscard]] const T *begin() const {
+            return data();
+        }
+
+        [[nodiscard]] const T *end() const {
+            return data() + size();
+        }
+
+        const T &operator[](size_t i) const {
+            return data()[i];
+        }
+
+        [[nodiscard]] const T &back() const {
+            return data()[size() - 1];
+        }
+
+        void reserve(size_t count) {
+            edit().reserve(count);
+        }
+
+        void push_back(T item) {
+            edit().push_back(item);
+        }
+
+        void pop_back() {
+            edit().pop_back();
+        }
+
+        bool operator==(const TokenColumn &other) const {
+            return std::equal(begin(), end(), other.begin(), other.end());
+        }
+    };
+
+    // Struct-of-arrays storage for a fully lexed buffer: one byte of kind and
+    // three 32-bit words of offset, length and payload per token. Spellings are
+    // recovered from the source, positions from a LineIndex over the same source.
+    // The payload is the SymbolId of an IDENTIFIER when lexed with a SymbolTable,
+    // and for a token with a Literal the index of its value in `literals`.
+    //
+    // relex() moves the tokens after an edit lazily: the offsets from token
+    // `shiftFrom` on are stored without `shift`, which offset() adds back, so
+    // the stored offsets are only exact up to `shiftFrom`. The four token
+    // columns of a buffer loaded from the token cache may be views of the
+    // mapped entry.
+    struct TokenBuffer {
+        static constexpr size_t unshifted = std::numeric_limits<size_t>::max();
+
+        std::string_view source;
+        TokenColumn<uint8_t> kinds;
+        TokenColumn<uint32_t> offsets;
+        TokenColumn<uint32_t> lengths;
+        TokenColumn<uint32_t> payloads;
+        std::vector<Literal> literals;
+        // Slots of `literals` no token refers to any more, filled first by relex()
+        std::vector<uint32_t> freeLiterals;
+        size_t shiftFrom = unshifted;
+        // Added modulo 2^32, so a shift to the left is a large unsigned one
+        uint32_t shift = 0;
+
+        void reserve(size_t count) {
+            kinds.reserve(count);
+            offsets.reserve(count);
+            lengths.reserve(count);
+            payloads.reserve(count);
+        }
+
+        void push(TokenType type, size_t offset, size_t length, uint32_t payload = 0) {
+            kinds.push_back(static_cast<uint8_t>(type));
+            offsets.push_back(static_cast<uint32_t>(offset));
+            lengths.push_back(static_cast<uint32_t>(length));
+            payloads.push_back(payload);
+        }
+
+        void push(const Token &token) {
+            uint32_t payload = token.payload;
+
+            if (hasLiteral(token.type)) {
+                payload = static_cast<uint32_t>(literals.size());
+                literals.push_back(token.literal);
+            }
+
+            push(token.type, token.offset, token.value.length(), payload);
+        }
+
+        // Appends tokens [from, other.size()) of a buffer over the same
+        // source. Neither buffer may have a pending shift.
+        void append(const TokenBuffer &other, size_t from) {
+            assert(shiftFrom == unshifted && other.shiftFrom == unshifted);
+            size_t first = size();
+
+            auto tail = [from](auto &target, const auto &source) {
+                auto &items = target.edit();
+                items.insert(items.end(), source.begin() + from, source.end());
+            };
+
+            tail(kinds, other.kinds);
+            tail(offsets, other.offsets);
+            tail(lengths, other.lengths);
+            tail(payloads, other.payloads);
+
+            if (other.literals.empty())
+                return;
+
+            std::vector<uint32_t> &indices = payloads.edit();
+
+            for (size_t i = first; i < size(); i++) {
+                if (hasLiteral(kind(i))) {
+                    literals.push_back(other.literals[indices[i]]);
+                    indices[i] = static_cast<uint32_t>(literals.size() - 1);
+                }
+            }
+        }
+
+        // Offset one past the last token, or `fallback` when the buffer is empty.
+        [[nodiscard]] size_t end(size_t fallback = 0) const {
+            return kinds.empty() ? fallback : offset(size() - 1) + lengths.back();
+        }
+
+        [[nodiscard]] size_t size() const {
+            return kinds.size();
+        }
+
+        [[nodiscard]] TokenType kind(size_t i) const {
+            return static_cast<TokenType>(kinds[i]);
+        }
+
+        [[nodiscard]] size_t offset(size_t i) const {
+            return i < shiftFrom ? offsets[i] : static_cast<uint32_t>(offsets[i] + shift);
+        }
+
+        [[nodiscard]] std::string_view value(size_t i) const {
+            return source.substr(offset(i), lengths[i]);
+        }
+
+        // Decoded value of token `i`, which must be a NUMBER, DECIMAL_NUMBER or CHAR_LIT.
+        [[nodiscard]] const Literal &literal(size_t i) const {
+            return literals[payloads[i]];
+        }
+    };
+
+    // Appends the tokens of `source` that start in [begin, end). The last one may
+    // run past `end`. Bytes the lexer rejects are kept as INVALID tokens.
+    inline void lexRange(TokenBuffer &buffer, size_t begin, size_t end, SymbolTable *symbols = nullptr) {
+        Lexer lexer(buffer.source, begin, symbols);
+
+        while (lexer.hasNext() && lexer.getIndex() < end) {
+            size_t start = lexer.getIndex();
+            auto token = lexer.next();
+
+            if (token.has_value())
+                buffer.push(*token);
+            else
+                buffer.push(TokenType::INVALID, start, lexer.getIndex() - start);
+        }
+    }
+
+    // Lexes the whole of `source` in one pass. The buffer always ends with an
+    // EOI token.
+    inline TokenBuffer lexAll(std::string_view source, SymbolTable *symbols = nullptr) {
+        assert(source.length() <= std::numeric_limits<uint32_t>::max());
+
+        TokenBuffer buffer;
+        buffer.source = source;
+        buffer.reserve(source.length() / 4 + 1);
+
+        lexRange(buffer, 0, source.length(), symbols);
+        buffer.push(TokenType::EOI, source.length(), 0);
+        return buffer;
+    }
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace xorLang {
+    enum class TokenType : uint8_t {
+        // File
+        NEWLINE, SPACE, TAB, EOI, COMMENT, INACTIVE_BLOCK, INVALID,
+
+        // Directives, see Lexer::directive()
+        DIRECTIVE, IF_DIRECTIVE, END_IF_DIRECTIVE, ASM_BLOCK,
+
+        // Symbols [D_ = Double, T_ = Triple]
+        D_L_PAREN, L_PAREN, D_R_PAREN, R_PAREN, D_L_BRACE, L_BRACE, D_R_BRACE,
+        R_BRACE, SEMICOLON, RETURN_ARROW, D_L_ANGLE, L_ANGLE, D_R_ANGLE, R_ANGLE,
+        D_L_BRACKET, L_BRACKET, D_R_BRACKET, R_BRACKET, COMMA, D_DOT, DOT, D_COLON,
+        COLON, HASH, AT, SUBTRACT, PLUS, STAR, SLASH, PLUS_EQ, START_EQ, SLASH_EQ,
+        SUBTRACT_EQ, EQ, D_EQ, AMPERSAND, BACK_TICK,
+
+        // Reserved keywords [UN = Unsafe]
+        FN, RETURN, CLASS, IF, ELSE, WHILE, FOR, IN, BREAK, CONTINUE, IMPORT, AS,
+        FROM, NULL_KW, SELF, SUPER, STATIC, CONST, MUT, ENUM, STRUCT,
+        UNION, TYPE, PUBLIC, PRIVATE, PROTECTED, EXTENDS, IMPLEMENTS, INSTANCE_OF,
+        UNSAFE, UN_DELETE, UN_CXX, UN_C, UN_ASM, UN_EXPOSE, FRIEND, OP, CNV,
+
+        // Reserved data types [UN = Unsafe]
+        INT_8BIT, INT_16BIT, INT_32BIT, INT_64BIT, INT_128BIT,
+        UINT_8BIT, UINT_16BIT, UINT_32BIT, UINT_64BIT, UINT_128BIT,
+        FLOAT_32BIT, FLOAT_64BIT, BOOL, CHAR, VOID, UN_VOID, INT_MAXBIT,
+        UINT_MAXBIT, FLOAT_MAXBIT,
+
+        // Literals
+        IDENTIFIER, DECIMAL_NUMBER, NUMBER, STRING, CHAR_LIT, TRUE, FALSE, NULL_LIT
+    };
+    
+    inline constexpr size_t tokenTypeCount = static_cast<size_t>(TokenType::NULL_LIT) + 1;
+
+    enum class Type : uint8_t {
+        SYMBOL, FILE, LITERAL, KEYWORD, DIRECTIVE
+    };
+
+    enum class Assoc : uint8_t {
+        NONE, LEFT, RIGHT
+    };
+
+    // Everything known about a token kind that does not depend on where it was
+    // lexed. `spelling` is the canonical source text of fixed tokens and empty
+    // for those whose text varies. A binary operator has a non-zero
+    // `precedence`, higher binds tighter.
+    struct TokenInfo {
+        TokenType type;
+        std::string_view name;
+        Type category;
+        std::string_view spelling;
+        uint8_t precedence = 0;
+        Assoc assoc = Assoc::NONE;
+    };
+
+    // One entry per TokenType, in declaration order so a kind indexes its own
+    // entry. The lexer's keyword table, the highlighter and the expression
+    // parser are all derived from this.
+    inline constexpr TokenInfo tokenInfos[] = {
+            {TokenType::NEWLINE, "NEWLINE", Type::FILE, "\n"},
+            {TokenType::SPACE, "SPACE", Type::FILE, ""},
+            {TokenType::TAB, "TAB", Type::FILE, ""},
+            {TokenType::EOI, "EOI", Type::FILE, ""},
+            {TokenType::COMMENT, "COMMENT", Type::FILE, ""},
+            {TokenType::INACTIVE_BLOCK, "INACTIVE_BLOCK", Type::FILE, ""},
+            {TokenType::INVALID, "INVALID", Type::FILE, ""},
+            {TokenType::DIRECTIVE, "DIRECTIVE", Type::DIRECTIVE, ""},
+            {TokenType::IF_DIRECTIVE, "IF_DIRECTIVE", Type::DIRECTIVE, ""},
+            {TokenType::END_IF_DIRECTIVE, "END_IF_DIRECTIVE", Type::DIRECTIVE, ""},
+            {TokenType::ASM_BLOCK, "ASM_BLOCK", Type::DIRECTIVE, ""},
+            {TokenType::D_L_PAREN, "D_L_PAREN", Type::SYMBOL, "(("},
+            {TokenType::L_PAREN, "L_PAREN", Type::SYMBOL, "("},
+            {TokenType::D_R_PAREN, "D_R_PAREN", Type::SYMBOL, "))"},
+            {TokenType::R_PAREN, "R_PAREN", Type::SYMBOL, ")"},
+            {TokenType::D_L_BRACE, "D_L_BRACE", Type::SYMBOL, "{{"},
+            {TokenType::L_BRACE, "L_BRACE", Type::SYMBOL, "{"},
+            {TokenType::D_R_BRACE, "D_R_BRACE", Type::SYMBOL, "}}"},
+            {TokenType::R_BRACE, "R_BRACE", Type::SYMBOL, "}"},
+            {TokenType::SEMICOLON, "SEMICOLON", Type::SYMBOL, ";"},
+            {TokenType::RETURN_ARROW, "RETURN_ARROW", Type::SYMBOL, "->"},
+            {TokenType::D_L_ANGLE, "D_L_ANGLE", Type::SYMBOL, "<<", 5, Assoc::LEFT},
+            {TokenType::L_ANGLE, "L_ANGLE", Type::SYMBOL, "<", 4, Assoc::LEFT},
+            {TokenType::D_R_ANGLE, "D_R_ANGLE", Type::SYMBOL, ">>", 5, Assoc::LEFT},
+            {TokenType::R_ANGLE, "R_ANGLE", Type::SYMBOL, ">", 4, Assoc::LEFT},
+            {TokenType::D_L_BRACKET, "D_L_BRACKET", Type::SYMBOL, "[["},
+            {TokenType::L_BRACKET, "L_BRACKET", Type::SYMBOL, "["},
+            {TokenType::D_R_BRACKET, "D_R_BRACKET", Type::SYMBOL, "]]"},
+            {TokenType::R_BRACKET, "R_BRACKET", Type::SYMBOL, "]"},
+            {TokenType::COMMA, "COMMA", Type::SYMBOL, ","},
+            {TokenType::D_DOT, "D_DOT", Type::SYMBOL, "..", 2, Assoc::NONE},
+            {TokenType::DOT, "DOT", Type::SYMBOL, "."},
+            {TokenType::D_COLON, "D_COLON", Type::SYMBOL, "::"},
+            {TokenType::COLON, "COLON", Type::SYMBOL, ":"},
+            {TokenType::HASH, "HASH", Type::SYMBOL, "#"},
+            {TokenType::AT, "AT", Type::SYMBOL, "@"},
+            {TokenType::SUBTRACT, "SUBTRACT", Type::SYMBOL, "-", 6, Assoc::LEFT},
+            {TokenType::PLUS, "PLUS", Type::SYMBOL, "+", 6, Assoc::LEFT},
+            {TokenType::STAR, "STAR", Type::SYMBOL, "*", 7, Assoc::LEFT},
+            {TokenType::SLASH, "SLASH", Type::SYMBOL, "/", 7, Assoc::LEFT},
+            {TokenType::PLUS_EQ, "PLUS_EQ", Type::SYMBOL, "+=", 1, Assoc::RIGHT},
+            {TokenType::START_EQ, "START_EQ", Type::SYMBOL, "*=", 1, Assoc::RIGHT},
+            {TokenType::SLASH_EQ, "SLASH_EQ", Type::SYMBOL, "/=", 1, Assoc::RIGHT},
+            {TokenType::SUBTRACT_EQ, "SUBTRACT_EQ", Type::SYMBOL, "-=", 1, Assoc::RIGHT},
+            {TokenType::EQ, "EQ", Type::SYMBOL, "=", 1, Assoc::RIGHT},
+            {TokenType::D_EQ, "D_EQ", Type::SYMBOL, "==", 3, Assoc::LEFT},
+            {TokenType::AMPERSAND, "AMPERSAND", Type::SYMBOL, "&"},
+            {TokenType::BACK_TICK, "BACK_TICK", Type::LITERAL, ""},
+            {TokenType::FN, "FN", Type::KEYWORD, "fn"},
+            {TokenType::RETURN, "RETURN", Type::KEYWORD, "return"},
+            {TokenType::CLASS, "CLASS", Type::KEYWORD, "class"},
+            {TokenType::IF, "IF", Type::KEYWORD, "if"},
+            {TokenType::ELSE, "ELSE", Type::KEYWORD, "else"},
+            {TokenType::WHILE, "WHILE", Type::KEYWORD, "while"},
+            {TokenType::FOR, "FOR", Type::KEYWORD, "for"},
+            {TokenType::IN, "IN", Type::KEYWORD, ""},
+            {TokenType::BREAK, "BREAK", Type::KEYWORD, "break"},
+            {TokenType::CONTINUE, "CONTINUE", Type::KEYWORD, "continue"},
+            {TokenType::IMPORT, "IMPORT", Type::KEYWORD, "import"},
+            {TokenType::AS, "AS", Type::KEYWORD, ""},
+            {TokenType::FROM, "FROM", Type::KEYWORD, ""},
+            {TokenType::NULL_KW, "NULL_KW", Type::KEYWORD, ""},
+            {TokenType::SELF, "SELF", Type::KEYWORD, "this"},
+            {TokenType::SUPER, "SUPER", Type::KEYWORD, "super"},
+            {TokenType::STATIC, "STATIC", Type::KEYWORD, "static"},
+            {TokenType::CONST, "CONST", Type::KEYWORD, "const"},
+            {TokenType::MUT, "MUT", Type::KEYWORD, "mut"},
+            {TokenType::ENUM, "ENUM", Type::KEYWORD, "enum"},
+            {TokenType::STRUCT, "STRUCT", Type::KEYWORD, "struct"},
+            {TokenType::UNION, "UNION", Type::KEYWORD, "union"},
+            {TokenType::TYPE, "TYPE", Type::KEYWORD, ""},
+            {TokenType::PUBLIC, "PUBLIC", Type::KEYWORD, "pub"},
+            {TokenType::PRIVATE, "PRIVATE", Type::KEYWORD, "pvt"},
+            {TokenType::PROTECTED, "PROTECTED", Type::KEYWORD, ""},
+            {TokenType::EXTENDS, "EXTENDS", Type::KEYWORD, "extends"},
+            {TokenType::IMPLEMENTS, "IMPLEMENTS", Type::KEYWORD, "implements"},
+            {TokenType::INSTANCE_OF, "INSTANCE_OF", Type::KEYWORD, "instanceof", 4, Assoc::LEFT},
+            {TokenType::UNSAFE, "UNSAFE", Type::KEYWORD, "unsafe"},
+            {TokenType::UN_DELETE, "UN_DELETE", Type::KEYWORD, ""},
+            {TokenType::UN_CXX, "UN_CXX", Type::KEYWORD, ""},
+            {TokenType::UN_C, "UN_C", Type::KEYWORD, ""},
+            {TokenType::UN_ASM, "UN_ASM", Type::KEYWORD, ""},
+            {TokenType::UN_EXPOSE, "UN_EXPOSE", Type::KEYWORD, ""},
+            {TokenType::FRIEND, "FRIEND", Type::KEYWORD, "friend"},
+            {TokenType::OP, "OP", Type::KEYWORD, "op"},
+            {TokenType::CNV, "CNV", Type::KEYWORD, "cnv"},
+            {TokenType::INT_8BIT, "INT_8BIT", Type::KEYWORD, "i8"},
+            {TokenType::INT_16BIT, "INT_16BIT", Type::KEYWORD, "i16"},
+            {TokenType::INT_32BIT, "INT_32BIT", Type::KEYWORD, "i32"},
+            {TokenType::INT_64BIT, "INT_64BIT", Type::KEYWORD, "i64"},
+            {TokenType::INT_128BIT, "INT_128BIT", Type::KEYWORD, "i128"},
+            {TokenType::UINT_8BIT, "UINT_8BIT", Type::KEYWORD, "u8"},
+            {TokenType::UINT_16BIT, "UINT_16BIT", Type::KEYWORD, "u16"},
+            {TokenType::UINT_32BIT, "UINT_32BIT", Type::KEYWORD, "u32"},
+            {TokenType::UINT_64BIT, "UINT_64BIT", Type::KEYWORD, "u64"},
+            {TokenType::UINT_128BIT, "UINT_128BIT", Type::KEYWORD, "u128"},
+            {TokenType::FLOAT_32BIT, "FLOAT_32BIT", Type::KEYWORD, "f32"},
+            {TokenType::FLOAT_64BIT, "FLOAT_64BIT", Type::KEYWORD, "f64"},
+            {TokenType::BOOL, "BOOL", Type::KEYWORD, "bool"},
+            {TokenType::CHAR, "CHAR", Type::KEYWORD, "char"},
+            {TokenType::VOID, "VOID", Type::KEYWORD, "void"},
+            {TokenType::UN_VOID, "UN_VOID", Type::KEYWORD, ""},
+            {TokenType::INT_MAXBIT, "INT_MAXBIT", Type::KEYWORD, ""},
+            {TokenType::UINT_MAXBIT, "UINT_MAXBIT", Type::KEYWORD, ""},
+            {TokenType::FLOAT_MAXBIT, "FLOAT_MAXBIT", Type::KEYWORD, ""},
+            {TokenType::IDENTIFIER, "IDENTIFIER", Type::LITERAL, ""},
+            {TokenType::DECIMAL_NUMBER, "DECIMAL_NUMBER", Type::LITERAL, ""},
+            {TokenType::NUMBER, "NUMBER", Type::LITERAL, ""},
+            {TokenType::STRING, "STRING", Type::LITERAL, ""},
+            {TokenType::CHAR_LIT, "CHAR_LIT", Type::LITERAL, ""},
+            {TokenType::TRUE, "TRUE", Type::LITERAL, "true"},
+            {TokenType::FALSE, "FALSE", Type::LITERAL, "false"},
+            {TokenType::NULL_LIT, "NULL_LIT", Type::LITERAL, "null"},
+    };
+
+    static_assert(std::size(tokenInfos) == tokenTypeCount);
+    static_assert([] {
+        for (size_t i = 0; i < tokenTypeCount; i++)
+            if (static_cast<size_t>(tokenInfos[i].type) != i)
+                return false;
+
+        return true;
+    }(), "tokenInfos must list every TokenType in declaration order");
+
+    constexpr const TokenInfo &tokenInfo(TokenType type) {
+        return tokenInfos[static_cast<size_t>(type)];
+    }
+
+    // Enumerator name, for statistics and debugging output.
+    constexpr std::string_view tokenTypeName(TokenType type) {
+        return tokenInfo(type).name;
+    }
+
+    constexpr Type getTypeCat(TokenType type) {
+        return tokenInfo(type).category;
+    }
+
+    // Zero when `type` is not a binary operator.
+    constexpr uint8_t binaryPrecedence(TokenType type) {
+        return tokenInfo(type).precedence;
+    }
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include "scan.h"
+
+// UTF-8 validation of whole source buffers. Sources are almost always valid and
+// mostly ASCII, so the kernels answer "is this block valid" as fast as possible
+// and only fall back to the scalar decoder to pin down where an error is.
+
+namespace xorLang {
+    namespace detail::utf8 {
+        inline bool isContinuation(uint8_t byte) {
+            return (byte & 0xC0) == 0x80;
+        }
+
+        // Length of the well-formed sequence starting at `from` (no overlong
+        // forms, surrogates or code points past U+10FFFF), 0 when it is not one.
+        inline size_t sequenceLength(const uint8_t *data, size_t size, size_t from) {
+            uint8_t lead = data[from];
+
+            if (lead < 0x80)
+                return 1;
+
+            size_t length;
+            uint8_t low = 0x80;
+            uint8_t high = 0xBF;
+
+            if (lead >= 0xC2 && lead <= 0xDF) {
+                length = 2;
+            } else if (lead >= 0xE0 && lead <= 0xEF) {
+                length = 3;
+                low = lead == 0xE0 ? 0xA0 : 0x80;
+                high = lead == 0xED ? 0x9F : 0xBF;
+            } else if (lead >= 0xF0 && lead <= 0xF4) {
+                length = 4;
+                low = lead == 0xF0 ? 0x90 : 0x80;
+                high = lead == 0xF4 ? 0x8F : 0xBF;
+            } else {
+                return 0;
+            }
+
+            if (from + length > size || data[from + 1] < low || data[from + 1] > high)
+                return 0;
+
+            for (size_t i = 2; i < length; i++)
+                if (!isContinuation(data[from + i]))
+                    return 0;
+
+            return length;
+        }
+
+        inline size_t scalarFind(const uint8_t *data, size_t size, size_t from) {
+            while (from < size) {
+                size_t length = sequenceLength(data, size, from);
+
+                if (length == 0)
+                    return from;
+
+                from += length;
+            }
+
+            return size;
+        }
+
+        // Where to resume decoding at `offset` when everything in [from, offset)
+        // was valid on its own: at the lead byte of a sequence that may still be
+        // open at `offset`, else at `offset`.
+        inline size_t sequenceStart(const uint8_t *data, size_t offset, size_t from) {
+            for (size_t back = 1; back <= 3 && offset - back >= from && offset >= back; back++) {
+                if (data[offset - back] >= 0xC0)
+                    return offset - back;
+
+                if (data[offset - back] < 0x80)
+                    break;
+            }
+
+            return offset;
+        }
+
+#if defined(XOR_SCAN_X86)
+        // Skips 16 bytes at a time while they are ASCII, decodes the rest.
+        inline size_t sse2Find(const uint8_t *data, size_t size, size_t from) {
+            while (from < size) {
+                for (; from + 16 <= size; from += 16) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+
+                    if (_mm_movemask_epi8(v) != 0)
+                        break;
+                }
+
+                size_t end = std::min(from + 16, size);
+
+                while (from < end) {
+                    size_t length = sequenceLength(data, size, from);
+
+                    if (length == 0)
+                        return from;
+
+                    from += length;
+                }
+            }
+
+            return size;
+        }
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+        // The lookup algorithm of Keiser and Lemire, "Validating UTF-8 In Less
+        // Than One Instruction Per Byte". Every error is a property of two
+        // adjacent bytes (checked with three 16-entry table lookups on their
+        // nibbles) or of a lead byte and the 2nd or 3rd byte after it. Blocks
+        // are 32 bytes, the previous block supplies the bytes before the first.
+        namespace avx2 {
+            constexpr uint8_t TOO_SHORT = 1 << 0;
+            constexpr uint8_t TOO_LONG = 1 << 1;
+            constexpr uint8_t OVERLONG_3 = 1 << 2;
+            constexpr uint8_t TOO_LARGE = 1 << 3;
+            constexpr uint8_t SURROGATE = 1 << 4;
+            constexpr uint8_t OVERLONG_2 = 1 << 5;
+            constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+            constexpr uint8_t OVERLONG_4 = 1 << 6;
+            constexpr uint8_t TWO_CONTS = 1 << 7;
+            constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+            inline __m256i table(const uint8_t (&entries)[16]) {
+                __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(entries));
+                return _mm256_broadcastsi128_si256(half);
+            }
+
+            inline __m256i highNibbles(__m256i v) {
+                return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+            }
+
+            // Bytes of `input` shifted back by N, pulling the first ones from `previous`.
+            template<int N>
+            inline __m256i before(__m256i input, __m256i previous) {
+                return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+            }
+
+            inline __m256i checkSpecialCases(__m256i input, __m256i prev1) {
+                static constexpr uint8_t byte1High[16] = {
+                        // 0_______ ________ <ASCII in byte 1>
+                        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                        // 10______ ________ <continuation in byte 1>
+                        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                        // 1100____ 1101____ 1110____ 1111____ <leads in byte 1>
+                        TOO_SHORT | OVERLONG_2,
+                        TOO_SHORT,
+                        TOO_SHORT | OVERLONG_3 | SURROGATE,
+                        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+                };
+                static constexpr uint8_t byte1Low[16] = {
+                        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                        CARRY | OVERLONG_2,
+                        CARRY,
+                        CARRY,
+                        CARRY | TOO_LARGE,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000,
+                        CARRY | TOO_LARGE | TOO_LARGE_1000
+                };
+                static constexpr uint8_t byte2High[16] = {
+                        // ________ 0_______ <ASCII in byte 2>
+                        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                        // ________ 1000____
+                        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+                        // ________ 1001____
+                        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                        // ________ 101_____
+                        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                        // ________ 11______
+                        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+                };
+
+                __m256i high1 = _mm256_shuffle_epi8(table(byte1High), highNibbles(prev1));
+                __m256i low1 = _mm256_shuffle_epi8(table(byte1Low), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+                __m256i high2 = _mm256_shuffle_epi8(table(byte2High), highNibbles(input));
+
+                return _mm256_and_si256(_mm256_and_si256(high1, low1), high2);
+            }
+
+            // A continuation that has to follow a 3 or 4 byte lead two or three
+            // bytes back must be flagged exactly where the 2-byte check did not.
+            inline __m256i checkMultibyteLengths(__m256i input, __m256i previous, __m256i special) {
+                __m256i prev2 = before<2>(input, previous);
+                __m256i prev3 = before<3>(input, previous);
+                __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+                __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+                __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+
+                return _mm256_xor_si256(must23, special);
+            }
+
+            // Non-zero in the last bytes when a sequence starts too late to end in the block.
+            inline __m256i incomplete(__m256i input) {
+                const __m256i limits = _mm256_setr_epi8(
+                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+
+                return _mm256_subs_epu8(input, limits);
+            }
+
+            inline size_t find(const uint8_t *data, size_t size, size_t from) {
+                __m256i previous = _mm256_setzero_si256();
+                __m256i pending = _mm256_setzero_si256();
+                size_t block = from;
+
+                for (; block + 32 <= size; block += 32) {
+                    __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + block));
+                    __m256i error;
+
+                    if (_mm256_movemask_epi8(input) == 0) {
+                        // ASCII only: valid unless the previous block left a sequence open
+                        error = pending;
+                    } else {
+                        __m256i special = checkSpecialCases(input, before<1>(input, previous));
+                        error = checkMultibyteLengths(input, previous, special);
+                    }
+
+                    if (!_mm256_testz_si256(error, error))
+                        break;
+
+                    pending = incomplete(input);
+                    previous = input;
+                }
+
+                // Everything before `block` is valid, except possibly a sequence
+                // left open across its start, so decode from that sequence on
+                return sse2Find(data, size, sequenceStart(data, block, from));
+            }
+        }
+#pragma GCC pop_options
+#endif
+    }
+
+    // Offset of the first byte at or after `from` that does not start a
+    // well-formed UTF-8 sequence, or the end of `input` when all of it is valid.
+    // `from` has to be at the start of a sequence.
+    inline size_t findInvalidUtf8(std::string_view input, size_t from = 0) {
+        const auto *data = reinterpret_cast<const uint8_t *>(input.data());
+
+#if defined(XOR_SCAN_X86)
+        switch (scanIsa()) {
+            case ScanIsa::AVX512:
+            case ScanIsa::AVX2:
+                return detail::utf8::avx2::find(data, input.length(), from);
+            case ScanIsa::SSE2:
+                return detail::utf8::sse2Find(data, input.length(), from);
+            case ScanIsa::SCALAR:
+                break;
+        }
+#endif
+
+        return detail::utf8::scalarFind(data, input.length(), from);
+    }
+
+    // Calls `visit(offset, length)` for every run of bytes of `input` that are not
+    // part of a well-formed sequence, in order.
+    template<typename Visit>
+    void forEachInvalidUtf8(std::string_view input, Visit &&visit) {
+        const auto *data = reinterpret_cast<const uint8_t *>(input.data());
+        size_t offset = findInvalidUtf8(input);
+
+        while (offset < input.length()) {
+            size_t end = offset + 1;
+
+            while (end < input.length() && detail::utf8::sequenceLength(data, input.length(), end) == 0)
+                end++;
+
+            visit(offset, end - offset);
+            offset = findInvalidUtf8(input, end);
+        }
+    }
+
+    // Number of code points in `text`: every byte that is not a continuation byte.
+    inline size_t countCodePoints(std::string_view text) {
+        size_t count = 0;
+
+        for (char c : text)
+            count += !detail::utf8::isContinuation(static_cast<uint8_t>(c));
+
+        return count;
+    }
+}
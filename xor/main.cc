@@ -1,60 +1,305 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <filesystem>
 #include "lexer/lexer.h"
+#include "lexer/lineIndex.h"
+#include "lexer/streamLexer.h"
+#include "lexer/utf8.h"
+#include "io/sourceFile.h"
+#include "driver/build.h"
+#include "driver/errorLog.h"
+#include "driver/highlighter.h"
+#include "driver/options.h"
+#include "driver/profiler.h"
+#include "driver/project.h"
 
-int main() {
-    using namespace xorLang;
-    using namespace std;
+using namespace xorLang;
+using namespace std;
 
-    stringstream cc;
+// Replays a lexed buffer through the same interface as the pull lexers.
+struct BufferCursor {
+    const TokenBuffer &buffer;
+    size_t index = 0;
 
-    ifstream myFile_Handler;
-    string myLine;
+    [[nodiscard]] bool hasNext() const {
+        return index + 1 < buffer.size();
+    }
 
-    // File Open in the Read Mode
-    myFile_Handler.open("libstd/src/util/string.xor");
+    [[nodiscard]] size_t getIndex() const {
+        return buffer.offset(index);
+    }
 
-    if(myFile_Handler.is_open())
-    {
-        // Keep reading the file
-        while(getline(myFile_Handler, myLine))
-        {
-            // print the line on the standard output
-            cc << myLine << endl;
-        }
-        // File Close
-        myFile_Handler.close();
+    [[nodiscard]] string_view text(size_t from) const {
+        return buffer.source.substr(from, getIndex() - from);
     }
-    else
-    {
-        cout << "Unable to open the file!";
+
+    optional<Token> next() {
+        size_t i = index++;
+
+        if (buffer.kind(i) == TokenType::INVALID)
+            return nullopt;
+
+        return Token{buffer.kind(i), buffer.value(i), buffer.offset(i), buffer.payloads[i]};
     }
+};
 
-    xorLang::Lexer lexer(cc.str());
+// Highlights tokens as they are lexed. Unknown tokens are still rendered and
+// reported to `errors`, `locate` turns their offset into a position. A source
+// that was not validated up front has every token checked for bad UTF-8.
+// False when the output could not be written.
+template<typename TokenSource, typename Locate>
+static bool highlight(TokenSource &lexer, HighlightFormat format, ErrorLog &errors, Locate locate,
+                      bool validated) {
+    OutputBuffer out(STDOUT_FILENO);
+    Highlighter highlighter(out, format);
 
     while (lexer.hasNext()) {
+        size_t start = lexer.getIndex();
         auto n = lexer.next();
-        std::string error;
+        string_view text = n.has_value() ? n->value : lexer.text(start);
 
         if (n.has_value()) {
-            if (n.value().type == TokenType::IDENTIFIER)
-                std::cout << "\x1b[93m";
-            else if (getTypeCat(n.value().type) == Type::KEYWORD)
-                std::cout << "\x1b[91m";
-            else if (n.value().type == TokenType::BACK_TICK || n.value().type == TokenType::STRING || n.value().type == TokenType::CHAR_LIT)
-                std::cout << "\x1b[32m";
-            else if (getTypeCat(n.value().type) == Type::SYMBOL)
-                std::cout << "\x1b[90m";
-
-            std::cout << n.value().value << "\x1b[0m";
+            highlighter.add(n->type, text);
         } else {
-            error = "\nUnknown token found:\n"
-                         " -- Line & Column: " + std::to_string(lexer.getLine()) + " - " + std::to_string(lexer.getColumn()) + "\n";
-            std::cerr << error;
+            highlighter.add(TokenType::INVALID, text);
+            errors.report(LexErrorKind::UNKNOWN_TOKEN, start, text.length(), locate);
+        }
+
+        if (!validated) {
+            forEachInvalidUtf8(text, [&](size_t offset, size_t length) {
+                errors.report(LexErrorKind::INVALID_UTF8, start + offset, length, locate);
+            });
+        }
+    }
+
+    highlighter.finish();
+
+    if (format == HighlightFormat::ANSI)
+        out.append("\nFinished lexing\n");
+
+    out.flush();
+
+    if (!out.good()) {
+        cerr << "Unable to write the highlighted output\n";
+        return false;
+    }
+
+    return true;
+}
+
+static int highlightFile(const Options &options, Profiler &profiler) {
+    const string &path = options.path;
+    ErrorLog errors(options.maxErrors);
+
+    // Pipes and stdin are lexed as they stream in, in bounded memory
+    if (path == "-") {
+        bool written;
+
+        {
+            auto scope = profiler.phase("highlight", path);
+            StreamLexer lexer(STDIN_FILENO);
+
+            written = highlight(lexer, options.highlight, errors,
+                                [&](size_t offset) { return lexer.position(offset); }, false);
         }
+
+        errors.write(cerr);
+        return written && errors.count() == 0 ? 0 : 1;
+    }
+
+    optional<SourceFile> file;
+
+    {
+        auto scope = profiler.phase("load", path);
+        file = SourceFile::open(path);
+    }
+
+    if (!file.has_value()) {
+        cerr << "Unable to open the file: " << path << "\n";
+        return 1;
+    }
+
+    // Only built once a diagnostic actually needs a line and column
+    optional<LineIndex> lines;
+
+    auto locate = [&](size_t offset) {
+        if (!lines.has_value())
+            lines.emplace(file->view());
+
+        return lines->position(offset);
+    };
+
+    {
+        auto scope = profiler.phase("validate", path);
+
+        forEachInvalidUtf8(file->view(), [&](size_t offset, size_t length) {
+            errors.report(LexErrorKind::INVALID_UTF8, offset, length, locate);
+        });
+    }
+
+    TokenBuffer buffer;
+
+    {
+        auto scope = profiler.phase("lex", path);
+        buffer = lexAll(file->view());
+    }
+
+    {
+        auto scope = profiler.phase("classify", path);
+        profiler.countTokens(buffer);
+    }
+
+    bool written;
+
+    {
+        auto scope = profiler.phase("output", path);
+        BufferCursor cursor{buffer};
+
+        written = highlight(cursor, options.highlight, errors, locate, true);
+    }
+
+    errors.write(cerr);
+    return written && errors.count() == 0 ? 0 : 1;
+}
+
+static bool isManifest(const string &path) {
+    std::error_code error;
+    return path.ends_with(".ini") || filesystem::is_directory(path, error);
+}
+
+// Builds a project, or the one file at `options.path` when it is not a
+// manifest: parses what changed since the last build, checks imports against
+// the project and the `-ih` interfaces, and writes the `-h` one.
+static int buildProject(const Options &options, Profiler &profiler) {
+    BuildPlan plan;
+    plan.name = options.name;
+    plan.interfaces = options.imports;
+    plan.header = options.header;
+
+    if (isManifest(options.path)) {
+        optional<Manifest> manifest = Manifest::load(options.path);
+
+        if (!manifest.has_value()) {
+            cerr << "Unable to read the project manifest: " << options.path << "\n";
+            return 1;
+        }
+
+        plan.sources = manifest->sourceFiles();
+        plan.sourcesPath = manifest->sourcesPath();
+
+        if (plan.name.empty())
+            plan.name = manifest->get("project", "name").value_or("");
+    } else {
+        std::error_code error;
+        uintmax_t size = filesystem::file_size(options.path, error);
+        plan.sources.push_back(SourceEntry{options.path, error ? 0 : size});
+        plan.sourcesPath = filesystem::path(options.path).parent_path();
+    }
+
+    if (!options.header.empty() && !isLibraryName(plan.name)) {
+        cerr << "The library needs a name with at most one underscore, pass one with -n\n";
+        return 1;
+    }
+
+    ThreadPool pool(options.jobs);
+    SymbolTable symbols;
+    optional<TokenCache> cache;
+    BuildSettings settings{.errorLimit = options.maxErrors, .pipeline = options.pipeline};
+
+    if (!options.cache.empty()) {
+        cache.emplace(options.cache);
+        settings.cache = &*cache;
+        plan.state = buildStatePath(options.cache, options.path).string();
+    }
+
+    BuildReport report = Build(plan, pool, symbols, profiler, settings).run();
+
+    if (cache.has_value())
+        cache->prune();
+
+    if (!report.badInterface.empty()) {
+        cerr << "Unable to read the library header: " << report.badInterface << "\n";
+        return 1;
+    }
+
+    size_t files = 0;
+    size_t tokens = 0;
+    size_t nodes = 0;
+    int status = 0;
+
+    auto scope = profiler.phase("output");
+
+    for (const FileResult &result : report.files) {
+        if (!result.opened) {
+            cerr << "Unable to open the file: " << result.path.string() << "\n";
+            status = 1;
+            continue;
+        }
+
+        result.errors.write(cerr, result.path.string());
+
+        // Syntax errors and unresolved imports fail the build as well
+        if (result.errors.count() != 0)
+            status = 1;
+
+        if (!result.parsed)
+            continue;
+
+        cout << result.path.string() << ": " << result.tokens << " tokens, " << result.nodes << " nodes\n";
+        files++;
+        tokens += result.tokens;
+        nodes += result.nodes;
+    }
+
+    if (files != 0)
+        cout << "\nFinished parsing " << files << " files, " << tokens << " tokens, " << nodes << " nodes, "
+             << symbols.size() << " distinct identifiers\n";
+
+    if (report.upToDate != 0)
+        cout << report.upToDate << " files up to date\n";
+
+    if (!options.imports.empty())
+        cout << "Resolved " << report.resolved << " imports\n";
+
+    if (report.headerFailed) {
+        cerr << "Unable to write the library header: " << options.header << "\n";
+        status = 1;
+    } else if (report.exported.has_value()) {
+        cout << "Wrote " << *report.exported << " symbols of " << plan.name << " to " << options.header << "\n";
+    }
+
+    return status;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && string_view(argv[1]) == "--help") {
+        cout << usage;
+        return 0;
+    }
+
+    optional<Options> options = parseOptions(argc, argv);
+
+    if (!options.has_value()) {
+        cerr << usage;
+        return 1;
+    }
+
+    selectTarget(options->target);
+    Profiler profiler(options->stats || !options->trace.empty());
+    bool library = !options->header.empty() || !options->imports.empty();
+    int status;
+
+    if (isManifest(options->path) || (library && options->path != "-"))
+        status = buildProject(*options, profiler);
+    else
+        status = highlightFile(*options, profiler);
+
+    if (options->stats)
+        profiler.writeSummary(cerr);
+
+    if (!options->trace.empty() && !profiler.writeTrace(options->trace)) {
+        cerr << "Unable to write the trace file: " << options->trace << "\n";
+        status = 1;
     }
 
-    std::cout << "\nFinished lexing\n";
-    return 0;
+    return status;
 }
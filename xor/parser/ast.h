@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include "../lexer/tokenBuffer.h"
+#include "../util/arena.h"
+
+namespace xorLang {
+    // Index of a node in Ast::nodes. Node 0 is always the FILE root, which no
+    // other node refers to, so 0 doubles as "no node".
+    using NodeId = uint32_t;
+    inline constexpr NodeId noNode = 0;
+
+    // Index of a token in the TokenBuffer the AST was parsed from.
+    using TokenId = uint32_t;
+    inline constexpr TokenId noToken = std::numeric_limits<TokenId>::max();
+
+    // Index into Ast::extra. A list is stored as its length followed by its
+    // items, and 0 is always the empty list.
+    using ExtraId = uint32_t;
+
+    enum class NodeKind : uint8_t {
+        FILE,
+
+        // Declarations
+        IMPORT, FUNCTION, OPERATOR, CONVERSION, CLASS, FIELD, PARAMETER, DIRECTIVE,
+
+        // Types
+        TYPE_NAME, ARRAY_TYPE, REFERENCE_TYPE,
+
+        // Statements
+        BLOCK, LOCAL, RETURN, IF, WHILE, FOR, BREAK, CONTINUE, EXPRESSION,
+
+        // Expressions
+        NAME, PATH, LITERAL, SELF, SUPER, UNARY, BINARY, CALL, MEMBER, INDEX, ERROR
+    };
+
+    // Declaration modifiers, a bit set in Node::modifiers.
+    enum Modifier : uint8_t {
+        MOD_PUBLIC = 1 << 0,
+        MOD_PRIVATE = 1 << 1,
+        MOD_PROTECTED = 1 << 2,
+        MOD_STATIC = 1 << 3,
+        MOD_MUT = 1 << 4,
+        MOD_CONST = 1 << 5,
+        MOD_UNSAFE = 1 << 6,
+        MOD_INLINE = 1 << 7
+    };
+
+    // Every node is 16 bytes: a kind, the modifiers of a declaration, the token
+    // it is named after and two operands whose meaning depends on the kind.
+    // Anything that does not fit in two operands is a record in Ast::extra.
+    //
+    //   kind            token                 a                    b
+    //   FILE            -                     declarations (list)  -
+    //   IMPORT          `import`              PATH or LITERAL      alias or noToken
+    //   FUNCTION        name                  signature (record)   BLOCK or noNode
+    //   OPERATOR        operator symbol       signature (record)   BLOCK or noNode
+    //   CONVERSION      `cnv`                 target type          BLOCK or noNode
+    //   CLASS           name                  members (list)       supertypes (record)
+    //   FIELD           name                  type                 initializer
+    //   PARAMETER       name or `this`        type                 -
+    //   DIRECTIVE       `#[...]` or `#[asm]`  -                    -
+    //   TYPE_NAME       first segment         segments (token list) -
+    //   ARRAY_TYPE      `[`                   element type         -
+    //   REFERENCE_TYPE  `&`                   referenced type      -
+    //   BLOCK           `{`                   statements (list)    -
+    //   LOCAL           name                  type                 initializer
+    //   RETURN          `return` / `ret`      value                -
+    //   IF              `if`                  condition            branches (record)
+    //   WHILE           `while`               condition            body
+    //   FOR             variable              iterable             body
+    //   BREAK/CONTINUE  keyword               -                    -
+    //   EXPRESSION      first token           expression           -
+    //   NAME/LITERAL/SELF/SUPER  the token    -                    -
+    //   PATH            first segment         segments (token list) -
+    //   UNARY           operator              operand              -
+    //   BINARY          operator              left                 right
+    //   CALL            `(`                   callee               arguments (list)
+    //   MEMBER          member name           object               -
+    //   INDEX           `[`                   object               index
+    //   ERROR           where parsing failed  -                    -
+    //
+    // A signature record is [parameters (list), return type]; the supertypes
+    // record [extends, implements (list)] and the branches record [then, else].
+    struct Node {
+        NodeKind kind;
+        uint8_t modifiers;
+        TokenId token;
+        uint32_t a;
+        uint32_t b;
+    };
+
+    static_assert(sizeof(Node) == 16);
+
+    struct ParseError {
+        TokenId token;
+        std::string_view message;
+    };
+
+    // The syntax tree of one file. Nodes, extra data and errors all live in
+    // the arena passed to parse(); resetting it tears the whole tree down.
+    // Tokens are referred to by index, so the TokenBuffer has to outlive it.
+    struct Ast {
+        const TokenBuffer *tokens = nullptr;
+        ArenaVector<Node> nodes;
+        ArenaVector<uint32_t> extra;
+        ArenaVector<ParseError> errors;
+
+        [[nodiscard]] const Node &node(NodeId id) const {
+            return nodes[id];
+        }
+
+        [[nodiscard]] std::string_view text(TokenId token) const {
+            return tokens->value(token);
+        }
+
+        [[nodiscard]] uint32_t listSize(ExtraId list) const {
+            return extra[list];
+        }
+
+        // Item `i` of a list, a NodeId or a TokenId depending on the list.
+        [[nodiscard]] uint32_t listItem(ExtraId list, uint32_t i) const {
+            return extra[list + 1 + i];
+        }
+    };
+}
@@ -0,0 +1,888 @@
+#pragma once
+
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+
+namespace xorLang {
+    // Hands the parser tokens that are still being lexed, see parsePipelined().
+    class TokenFeed {
+    public:
+        virtual ~TokenFeed() = default;
+
+        // Appends at least one token to the buffer being parsed.
+        virtual void pull() = 0;
+    };
+
+    // Recursive-descent parser over a lexed TokenBuffer. Whitespace, comments,
+    // the `#[if ...]` directives the lexer already resolved and bytes it
+    // rejected are skipped, and the lexer's doubled brackets (`((`, `]]`, ...)
+    // are read as two single ones. Binary expressions are parsed by
+    // precedence climbing over tokenInfos.
+    //
+    // Errors never stop the parse: each one is recorded in Ast::errors, an
+    // ERROR node takes the place of what could not be parsed, and the parser
+    // skips ahead to the end of the statement or to the next declaration.
+    class Parser {
+        const TokenBuffer &tokens;
+        TokenFeed *feed;
+        Ast ast;
+
+        // Items of the lists being built, innermost last
+        std::vector<uint32_t> scratch;
+
+        TokenId pos = 0;
+        // Set once the first half of a doubled bracket at `pos` was consumed
+        bool split = false;
+        TokenId lastError = noToken;
+
+        // Depth of the parse functions that call themselves, capped far below
+        // what the stack holds so that deeply nested input is an error rather
+        // than a crash
+        static constexpr uint32_t maxNesting = 1000;
+        uint32_t nesting = 0;
+
+        struct Nested {
+            Parser &parser;
+
+            explicit Nested(Parser &parser): parser(parser) {
+                parser.nesting++;
+            }
+
+            ~Nested() {
+                parser.nesting--;
+            }
+        };
+
+        static bool isTrivia(TokenType type) {
+            return type == TokenType::SPACE || type == TokenType::TAB || type == TokenType::NEWLINE ||
+                   type == TokenType::COMMENT || type == TokenType::INACTIVE_BLOCK || type == TokenType::INVALID ||
+                   type == TokenType::IF_DIRECTIVE || type == TokenType::END_IF_DIRECTIVE;
+        }
+
+        static TokenType single(TokenType type) {
+            switch (type) {
+                case TokenType::D_L_PAREN:
+                    return TokenType::L_PAREN;
+                case TokenType::D_R_PAREN:
+                    return TokenType::R_PAREN;
+                case TokenType::D_L_BRACE:
+                    return TokenType::L_BRACE;
+                case TokenType::D_R_BRACE:
+                    return TokenType::R_BRACE;
+                case TokenType::D_L_BRACKET:
+                    return TokenType::L_BRACKET;
+                case TokenType::D_R_BRACKET:
+                    return TokenType::R_BRACKET;
+                default:
+                    return type;
+            }
+        }
+
+        static bool isTypeKeyword(TokenType type) {
+            return type >= TokenType::INT_8BIT && type <= TokenType::FLOAT_MAXBIT;
+        }
+
+        // Kind of token `i`, pulling tokens from the feed until it has been lexed.
+        TokenType kind(TokenId i) {
+            while (i >= tokens.size())
+                feed->pull();
+
+            return tokens.kind(i);
+        }
+
+        // The current token is always lexed already; EOI is not trivia, so the
+        // cursor never moves past it.
+        void skipTrivia() {
+            while (isTrivia(kind(pos)))
+                pos++;
+        }
+
+        [[nodiscard]] TokenType peek() const {
+            return single(tokens.kind(pos));
+        }
+
+        // The significant token after the current one.
+        TokenType peekNext() {
+            TokenType current = tokens.kind(pos);
+
+            if (current == TokenType::EOI)
+                return current;
+
+            if (!split && single(current) != current)
+                return single(current);
+
+            TokenId next = pos + 1;
+
+            while (isTrivia(kind(next)))
+                next++;
+
+            return single(kind(next));
+        }
+
+        TokenId advance() {
+            TokenId token = pos;
+
+            if (peek() == TokenType::EOI)
+                return token;
+
+            if (!split && single(tokens.kind(pos)) != tokens.kind(pos)) {
+                split = true;
+                return token;
+            }
+
+            split = false;
+            pos++;
+            skipTrivia();
+            return token;
+        }
+
+        bool accept(TokenType type) {
+            if (peek() != type)
+                return false;
+
+            advance();
+            return true;
+        }
+
+        // Accepts an identifier spelled `word`, for words that only mean
+        // something in one place and are not reserved.
+        bool acceptWord(std::string_view word) {
+            if (peek() != TokenType::IDENTIFIER || ast.text(pos) != word)
+                return false;
+
+            advance();
+            return true;
+        }
+
+        void error(std::string_view message) {
+            // Only the first of a cascade of errors at one token is worth reporting
+            if (lastError == pos)
+                return;
+
+            lastError = pos;
+            ast.errors.push(ParseError{pos, message});
+        }
+
+        TokenId expect(TokenType type, std::string_view message) {
+            if (peek() == type)
+                return advance();
+
+            error(message);
+            return noToken;
+        }
+
+        NodeId add(NodeKind kind, TokenId token, uint32_t a = 0, uint32_t b = 0, uint8_t modifiers = 0) {
+            return ast.nodes.push(Node{kind, modifiers, token, a, b});
+        }
+
+        NodeId fail(std::string_view message) {
+            error(message);
+            return add(NodeKind::ERROR, pos);
+        }
+
+        // Moves the items pushed to `scratch` since `base` into a list.
+        ExtraId list(size_t base) {
+            auto count = static_cast<uint32_t>(scratch.size() - base);
+
+            if (count == 0)
+                return 0;
+
+            ExtraId list = ast.extra.push(count);
+
+            for (size_t i = base; i < scratch.size(); i++)
+                ast.extra.push(scratch[i]);
+
+            scratch.resize(base);
+            return list;
+        }
+
+        ExtraId record(std::initializer_list<uint32_t> fields) {
+            auto record = ast.extra.size();
+
+            for (uint32_t field : fields)
+                ast.extra.push(field);
+
+            return record;
+        }
+
+        // Skips the rest of a broken statement: up to and including the next
+        // `;`, or up to the `}` closing the enclosing block.
+        void skipStatement() {
+            int depth = 0;
+
+            while (peek() != TokenType::EOI) {
+                TokenType type = peek();
+
+                if (depth == 0 && type == TokenType::SEMICOLON) {
+                    advance();
+                    return;
+                }
+
+                if (type == TokenType::R_BRACE && depth-- == 0)
+                    return;
+
+                if (type == TokenType::L_BRACE)
+                    depth++;
+
+                advance();
+            }
+        }
+
+        // Skips what is nested too deeply to parse, up to the `;` or `}` ending
+        // the enclosing statement or block, which the levels above then close
+        // without reporting every bracket left open.
+        NodeId tooDeep() {
+            NodeId result = fail("nested too deeply");
+            int depth = 0;
+
+            while (peek() != TokenType::EOI) {
+                TokenType type = peek();
+
+                if (depth == 0 && (type == TokenType::SEMICOLON || type == TokenType::R_BRACE))
+                    break;
+
+                if (type == TokenType::L_BRACE)
+                    depth++;
+                else if (type == TokenType::R_BRACE)
+                    depth--;
+
+                advance();
+            }
+
+            lastError = pos;
+            return result;
+        }
+
+        // Skips a broken declaration up to where the next one may start. In a
+        // class a `}` always closes the class, so it is left alone even where
+        // the broken declaration would start, as in `class A { pub }`.
+        void skipDeclaration(bool inClass) {
+            int depth = 0;
+
+            if (peek() != TokenType::EOI && !(inClass && peek() == TokenType::R_BRACE))
+                advance();
+
+            while (peek() != TokenType::EOI) {
+                TokenType type = peek();
+
+                if (depth == 0) {
+                    switch (type) {
+                        case TokenType::FN:
+                        case TokenType::CLASS:
+                        case TokenType::OP:
+                        case TokenType::CNV:
+                        case TokenType::IMPORT:
+                        case TokenType::PUBLIC:
+                        case TokenType::PRIVATE:
+                        case TokenType::PROTECTED:
+                        case TokenType::DIRECTIVE:
+                        case TokenType::ASM_BLOCK:
+                        case TokenType::R_BRACE:
+                            return;
+                        case TokenType::SEMICOLON:
+                            advance();
+                            return;
+                        default:
+                            break;
+                    }
+                }
+
+                if (type == TokenType::L_BRACE)
+                    depth++;
+                else if (type == TokenType::R_BRACE)
+                    depth--;
+
+                advance();
+            }
+        }
+
+        uint8_t modifiers() {
+            uint8_t modifiers = 0;
+
+            while (true) {
+                switch (peek()) {
+                    case TokenType::PUBLIC:
+                        modifiers |= MOD_PUBLIC;
+                        break;
+                    case TokenType::PRIVATE:
+                        modifiers |= MOD_PRIVATE;
+                        break;
+                    case TokenType::PROTECTED:
+                        modifiers |= MOD_PROTECTED;
+                        break;
+                    case TokenType::STATIC:
+                        modifiers |= MOD_STATIC;
+                        break;
+                    case TokenType::MUT:
+                        modifiers |= MOD_MUT;
+                        break;
+                    case TokenType::CONST:
+                        modifiers |= MOD_CONST;
+                        break;
+                    case TokenType::UNSAFE:
+                        modifiers |= MOD_UNSAFE;
+                        break;
+                    default:
+                        return modifiers;
+                }
+
+                advance();
+            }
+        }
+
+        // `a::b::c` as a list of its segment tokens.
+        ExtraId path() {
+            size_t base = scratch.size();
+            scratch.push_back(advance());
+
+            while (peek() == TokenType::D_COLON) {
+                advance();
+
+                if (peek() == TokenType::IDENTIFIER || peek() == TokenType::STAR) {
+                    scratch.push_back(advance());
+                } else {
+                    error("expected a name after `::`");
+                    break;
+                }
+            }
+
+            return list(base);
+        }
+
+        NodeId type() {
+            Nested nested(*this);
+
+            if (nesting > maxNesting)
+                return tooDeep();
+
+            if (peek() == TokenType::AMPERSAND) {
+                TokenId token = advance();
+                return add(NodeKind::REFERENCE_TYPE, token, type());
+            }
+
+            if (peek() != TokenType::IDENTIFIER && !isTypeKeyword(peek()))
+                return fail("expected a type");
+
+            TokenId first = pos;
+            NodeId result = add(NodeKind::TYPE_NAME, first, path());
+
+            while (peek() == TokenType::L_BRACKET && peekNext() == TokenType::R_BRACKET) {
+                TokenId token = advance();
+                advance();
+                result = add(NodeKind::ARRAY_TYPE, token, result);
+            }
+
+            return result;
+        }
+
+        // `name: Type`, `Type name`, `this` or `&this`, optionally after `inline`.
+        NodeId parameter() {
+            uint8_t flags = 0;
+
+            if (peek() == TokenType::SELF || (peek() == TokenType::AMPERSAND && peekNext() == TokenType::SELF)) {
+                NodeId reference = noNode;
+
+                if (peek() == TokenType::AMPERSAND)
+                    reference = add(NodeKind::REFERENCE_TYPE, advance());
+
+                return add(NodeKind::PARAMETER, advance(), reference);
+            }
+
+            while (peek() == TokenType::IDENTIFIER && ast.text(pos) == "inline" && peekNext() != TokenType::COLON) {
+                flags |= MOD_INLINE;
+                advance();
+            }
+
+            if (peek() == TokenType::IDENTIFIER && peekNext() == TokenType::COLON) {
+                TokenId name = advance();
+                advance();
+                return add(NodeKind::PARAMETER, name, type(), 0, flags);
+            }
+
+            NodeId parameterType = type();
+            TokenId name = expect(TokenType::IDENTIFIER, "expected a parameter name");
+            return add(NodeKind::PARAMETER, name, parameterType, 0, flags);
+        }
+
+        // `(parameters) -> ReturnType` as a signature record.
+        ExtraId signature() {
+            size_t base = scratch.size();
+
+            if (expect(TokenType::L_PAREN, "expected `(` to open the parameters") != noToken) {
+                while (peek() != TokenType::R_PAREN && peek() != TokenType::EOI) {
+                    scratch.push_back(parameter());
+
+                    if (!accept(TokenType::COMMA))
+                        break;
+                }
+
+                expect(TokenType::R_PAREN, "expected `)` after the parameters");
+            }
+
+            ExtraId parameters = list(base);
+            NodeId returnType = accept(TokenType::RETURN_ARROW) ? type() : noNode;
+            return record({parameters, returnType});
+        }
+
+        // A body, or `;` for a declaration without one.
+        NodeId body() {
+            if (peek() == TokenType::L_BRACE) {
+                NodeId result = block();
+                accept(TokenType::SEMICOLON);
+                return result;
+            }
+
+            expect(TokenType::SEMICOLON, "expected a body or `;`");
+            return noNode;
+        }
+
+        NodeId function(uint8_t flags) {
+            advance();
+            TokenId name = expect(TokenType::IDENTIFIER, "expected a function name");
+            ExtraId signature = this->signature();
+            return add(NodeKind::FUNCTION, name, signature, body(), flags);
+        }
+
+        NodeId operatorDeclaration(uint8_t flags, bool inClass) {
+            advance();
+            TokenType symbol = peek();
+
+            if (getTypeCat(symbol) != Type::SYMBOL || symbol == TokenType::L_PAREN || symbol == TokenType::L_BRACE ||
+                symbol == TokenType::R_BRACE || symbol == TokenType::SEMICOLON) {
+                NodeId result = fail("expected an operator symbol after `op`");
+                skipDeclaration(inClass);
+                return result;
+            }
+
+            TokenId token = advance();
+
+            if (symbol == TokenType::L_BRACKET)
+                expect(TokenType::R_BRACKET, "expected `]` after `op [`");
+
+            ExtraId signature = this->signature();
+            return add(NodeKind::OPERATOR, token, signature, body(), flags);
+        }
+
+        NodeId conversion(uint8_t flags) {
+            TokenId token = advance();
+            expect(TokenType::RETURN_ARROW, "expected `->` and the target type after `cnv`");
+            NodeId target = type();
+            return add(NodeKind::CONVERSION, token, target, body(), flags);
+        }
+
+        NodeId field(uint8_t flags) {
+            TokenId name = advance();
+            NodeId fieldType = noNode;
+            NodeId initializer = noNode;
+
+            if (expect(TokenType::COLON, "expected `:` and the field type") != noToken)
+                fieldType = type();
+
+            if (accept(TokenType::EQ))
+                initializer = expression();
+
+            if (expect(TokenType::SEMICOLON, "expected `;` after the field") == noToken)
+                skipStatement();
+
+            return add(NodeKind::FIELD, name, fieldType, initializer, flags);
+        }
+
+        NodeId classDeclaration(uint8_t flags) {
+            Nested nested(*this);
+
+            if (nesting > maxNesting)
+                return tooDeep();
+
+            advance();
+            TokenId name = expect(TokenType::IDENTIFIER, "expected a class name");
+            ExtraId supertypes = 0;
+
+            if (peek() == TokenType::EXTENDS || peek() == TokenType::IMPLEMENTS) {
+                NodeId base = accept(TokenType::EXTENDS) ? type() : noNode;
+                size_t interfaces = scratch.size();
+
+                if (accept(TokenType::IMPLEMENTS)) {
+                    do {
+                        scratch.push_back(type());
+                    } while (accept(TokenType::COMMA));
+                }
+
+                ExtraId implemented = list(interfaces);
+                supertypes = record({base, implemented});
+            }
+
+            size_t base = scratch.size();
+
+            if (expect(TokenType::L_BRACE, "expected `{` to open the class body") != noToken) {
+                while (peek() != TokenType::R_BRACE && peek() != TokenType::EOI) {
+                    NodeId member = declaration(true);
+
+                    if (member != noNode)
+                        scratch.push_back(member);
+                }
+
+                expect(TokenType::R_BRACE, "expected `}` to close the class body");
+                accept(TokenType::SEMICOLON);
+            }
+
+            return add(NodeKind::CLASS, name, list(base), supertypes, flags);
+        }
+
+        NodeId import() {
+            TokenId token = advance();
+            NodeId target;
+
+            if (peek() == TokenType::STRING) {
+                target = add(NodeKind::LITERAL, advance());
+            } else if (peek() == TokenType::IDENTIFIER) {
+                TokenId first = pos;
+                target = add(NodeKind::PATH, first, path());
+            } else {
+                target = fail("expected a module path after `import`");
+            }
+
+            TokenId alias = noToken;
+
+            if (acceptWord("as"))
+                alias = expect(TokenType::IDENTIFIER, "expected a name after `as`");
+
+            if (expect(TokenType::SEMICOLON, "expected `;` after the import") == noToken)
+                skipStatement();
+
+            return add(NodeKind::IMPORT, token, target, alias);
+        }
+
+        // A DIRECTIVE or an ASM_BLOCK, each a single token.
+        NodeId directive() {
+            TokenId token = advance();
+            return add(NodeKind::DIRECTIVE, token);
+        }
+
+        // A declaration at file level, or a member when `inClass`. Returns
+        // noNode for a stray `;`.
+        NodeId declaration(bool inClass) {
+            if (peek() == TokenType::DIRECTIVE || peek() == TokenType::ASM_BLOCK)
+                return directive();
+
+            uint8_t flags = modifiers();
+
+            switch (peek()) {
+                case TokenType::FN:
+                    return function(flags);
+                case TokenType::OP:
+                    return operatorDeclaration(flags, inClass);
+                case TokenType::CNV:
+                    return conversion(flags);
+                case TokenType::CLASS:
+                    return classDeclaration(flags);
+                case TokenType::IMPORT:
+                    if (!inClass && flags == 0)
+                        return import();
+                    break;
+                case TokenType::IDENTIFIER:
+                    if (inClass)
+                        return field(flags);
+                    break;
+                case TokenType::SEMICOLON:
+                    if (flags == 0) {
+                        advance();
+                        return noNode;
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            NodeId result = fail(inClass ? "expected a member declaration" : "expected a declaration");
+            skipDeclaration(inClass);
+            return result;
+        }
+
+        NodeId block() {
+            Nested nested(*this);
+
+            if (nesting > maxNesting)
+                return tooDeep();
+
+            TokenId token = advance();
+            size_t base = scratch.size();
+
+            while (peek() != TokenType::R_BRACE && peek() != TokenType::EOI) {
+                TokenId before = pos;
+                bool wasSplit = split;
+                NodeId item = statement();
+
+                if (item != noNode)
+                    scratch.push_back(item);
+
+                // Never get stuck on a token no statement can start with
+                if (pos == before && split == wasSplit)
+                    advance();
+            }
+
+            expect(TokenType::R_BRACE, "expected `}` to close the block");
+            return add(NodeKind::BLOCK, token, list(base));
+        }
+
+        // Expects the `;` ending a statement, skipping to it when it is missing.
+        void endStatement() {
+            if (expect(TokenType::SEMICOLON, "expected `;` after the statement") == noToken)
+                skipStatement();
+        }
+
+        NodeId statement() {
+            switch (peek()) {
+                case TokenType::L_BRACE:
+                    return block();
+                case TokenType::DIRECTIVE:
+                case TokenType::ASM_BLOCK:
+                    return directive();
+                case TokenType::SEMICOLON:
+                    advance();
+                    return noNode;
+                case TokenType::RETURN: {
+                    TokenId token = advance();
+                    NodeId value = peek() == TokenType::SEMICOLON ? noNode : expression();
+                    endStatement();
+                    return add(NodeKind::RETURN, token, value);
+                }
+                case TokenType::BREAK:
+                case TokenType::CONTINUE: {
+                    TokenId token = advance();
+                    endStatement();
+                    return add(tokens.kind(token) == TokenType::BREAK ? NodeKind::BREAK : NodeKind::CONTINUE, token);
+                }
+                case TokenType::IF:
+                    return ifStatement();
+                case TokenType::WHILE: {
+                    TokenId token = advance();
+                    NodeId condition = expression();
+                    return add(NodeKind::WHILE, token, condition, blockOrFail());
+                }
+                case TokenType::FOR: {
+                    advance();
+                    TokenId variable = expect(TokenType::IDENTIFIER, "expected a loop variable after `for`");
+
+                    if (!acceptWord("in"))
+                        error("expected `in` after the loop variable");
+
+                    NodeId iterable = expression();
+                    return add(NodeKind::FOR, variable, iterable, blockOrFail());
+                }
+                case TokenType::MUT:
+                case TokenType::CONST:
+                    return local();
+                default: {
+                    TokenId token = pos;
+                    NodeId value = expression();
+                    endStatement();
+                    return add(NodeKind::EXPRESSION, token, value);
+                }
+            }
+        }
+
+        NodeId blockOrFail() {
+            if (peek() == TokenType::L_BRACE)
+                return block();
+
+            return fail("expected `{`");
+        }
+
+        // An `else if` chain of any length is read in a loop; the IF nodes are
+        // added innermost first, as if each `else if` had been parsed by a call.
+        NodeId ifStatement() {
+            size_t base = scratch.size();
+            NodeId otherwise = noNode;
+
+            while (true) {
+                TokenId token = advance();
+                NodeId condition = expression();
+                NodeId then = blockOrFail();
+                scratch.insert(scratch.end(), {token, condition, then});
+
+                if (!accept(TokenType::ELSE))
+                    break;
+
+                if (peek() != TokenType::IF) {
+                    otherwise = blockOrFail();
+                    break;
+                }
+            }
+
+            while (scratch.size() > base) {
+                NodeId then = scratch.back();
+                NodeId condition = scratch.end()[-2];
+                TokenId token = scratch.end()[-3];
+                scratch.resize(scratch.size() - 3);
+                otherwise = add(NodeKind::IF, token, condition, record({then, otherwise}));
+            }
+
+            return otherwise;
+        }
+
+        // `mut name: Type = value;`, the type or the value may be left out.
+        NodeId local() {
+            uint8_t flags = modifiers();
+            TokenId name = expect(TokenType::IDENTIFIER, "expected a variable name");
+            NodeId localType = accept(TokenType::COLON) ? type() : noNode;
+            NodeId initializer = accept(TokenType::EQ) ? expression() : noNode;
+
+            endStatement();
+            return add(NodeKind::LOCAL, name, localType, initializer, flags);
+        }
+
+        NodeId expression(uint8_t minimum = 1) {
+            Nested nested(*this);
+
+            if (nesting > maxNesting)
+                return tooDeep();
+
+            NodeId left = unary();
+
+            while (true) {
+                TokenType op = peek();
+                const TokenInfo &info = tokenInfo(op);
+
+                if (info.precedence == 0 || info.precedence < minimum)
+                    return left;
+
+                TokenId token = advance();
+
+                auto next = static_cast<uint8_t>(info.assoc == Assoc::RIGHT ? info.precedence : info.precedence + 1);
+                left = add(NodeKind::BINARY, token, left, expression(next));
+            }
+        }
+
+        NodeId unary() {
+            Nested nested(*this);
+
+            if (nesting > maxNesting)
+                return tooDeep();
+
+            switch (peek()) {
+                case TokenType::SUBTRACT:
+                case TokenType::PLUS:
+                case TokenType::AMPERSAND: {
+                    TokenId token = advance();
+                    return add(NodeKind::UNARY, token, unary());
+                }
+                default:
+                    return postfix(primary());
+            }
+        }
+
+        NodeId primary() {
+            switch (peek()) {
+                case TokenType::IDENTIFIER: {
+                    if (peekNext() != TokenType::D_COLON)
+                        return add(NodeKind::NAME, advance());
+
+                    TokenId first = pos;
+                    return add(NodeKind::PATH, first, path());
+                }
+                case TokenType::NUMBER:
+                case TokenType::DECIMAL_NUMBER:
+                case TokenType::STRING:
+                case TokenType::BACK_TICK:
+                case TokenType::CHAR_LIT:
+                case TokenType::TRUE:
+                case TokenType::FALSE:
+                case TokenType::NULL_LIT:
+                    return add(NodeKind::LITERAL, advance());
+                case TokenType::SELF:
+                    return add(NodeKind::SELF, advance());
+                case TokenType::SUPER:
+                    return add(NodeKind::SUPER, advance());
+                case TokenType::L_PAREN: {
+                    advance();
+                    NodeId inner = expression();
+                    expect(TokenType::R_PAREN, "expected `)`");
+                    return inner;
+                }
+                default:
+                    return fail("expected an expression");
+            }
+        }
+
+        NodeId postfix(NodeId left) {
+            while (true) {
+                switch (peek()) {
+                    case TokenType::L_PAREN: {
+                        TokenId token = advance();
+                        size_t base = scratch.size();
+
+                        while (peek() != TokenType::R_PAREN && peek() != TokenType::EOI) {
+                            scratch.push_back(expression());
+
+                            if (!accept(TokenType::COMMA))
+                                break;
+                        }
+
+                        expect(TokenType::R_PAREN, "expected `)` after the arguments");
+                        left = add(NodeKind::CALL, token, left, list(base));
+                        break;
+                    }
+                    case TokenType::DOT: {
+                        advance();
+                        TokenType kind = peek();
+
+                        if (kind != TokenType::IDENTIFIER && getTypeCat(kind) != Type::KEYWORD)
+                            return add(NodeKind::MEMBER, noToken, left, fail("expected a member name after `.`"));
+
+                        left = add(NodeKind::MEMBER, advance(), left);
+                        break;
+                    }
+                    case TokenType::L_BRACKET: {
+                        TokenId token = advance();
+                        NodeId index = expression();
+                        expect(TokenType::R_BRACKET, "expected `]`");
+                        left = add(NodeKind::INDEX, token, left, index);
+                        break;
+                    }
+                    default:
+                        return left;
+                }
+            }
+        }
+
+    public:
+        // Without a feed `tokens` has to be complete, i.e. end in EOI.
+        Parser(const TokenBuffer &tokens, Arena &arena, TokenFeed *feed = nullptr): tokens(tokens), feed(feed) {
+            // Sized from the source, since a fed buffer starts out empty: about
+            // a node per 12 bytes of typical code
+            auto bytes = static_cast<uint32_t>(tokens.source.length());
+
+            ast.tokens = &tokens;
+            ast.nodes = ArenaVector<Node>(arena, bytes / 12 + 16);
+            ast.extra = ArenaVector<uint32_t>(arena, bytes / 48 + 16);
+            ast.errors = ArenaVector<ParseError>(arena);
+
+            // The root and the empty list
+            ast.nodes.push(Node{NodeKind::FILE, 0, noToken, 0, 0});
+            ast.extra.push(0);
+        }
+
+        Ast parse() {
+            skipTrivia();
+            size_t base = scratch.size();
+
+            while (peek() != TokenType::EOI) {
+                NodeId item = declaration(false);
+
+                if (item != noNode)
+                    scratch.push_back(item);
+            }
+
+            ast.nodes[0].a = list(base);
+            return ast;
+        }
+    };
+
+    // Parses a buffer from lexAll() or lexParallel(), which has to end in EOI,
+    // into an AST allocated in `arena`.
+    inline Ast parse(const TokenBuffer &tokens, Arena &arena) {
+        return Parser(tokens, arena).parse();
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <thread>
+#include "parser.h"
+#include "../util/spscRing.h"
+
+namespace xorLang {
+    // Tokens cross from the lexer thread to the parser one cache line at a
+    // time: up to four tokens with the fields of a TokenBuffer entry.
+    struct alignas(64) TokenBlock {
+        static constexpr uint8_t capacity = 4;
+
+        uint32_t offsets[capacity];
+        uint32_t lengths[capacity];
+        uint32_t payloads[capacity];
+        uint8_t kinds[capacity];
+        uint8_t count = 0;
+    };
+
+    static_assert(sizeof(TokenBlock) == 64);
+
+    // Lexes a source on a thread of its own while the parser consumes the
+    // tokens on the calling thread. Decoded literals take a second ring. The
+    // producer always pushes a literal before the block holding its token, so
+    // the consumer never waits on that ring. The producer only waits on it
+    // while the consumer still has published blocks to work through.
+    class TokenPipe final : public TokenFeed {
+        static constexpr size_t blockSlots = 1024;
+        static constexpr size_t literalSlots = 256;
+
+        TokenBuffer &buffer;
+        SpscRing<TokenBlock> blocks{blockSlots};
+        SpscRing<Literal> literals{literalSlots};
+        std::thread producer;
+
+        void produce(std::string_view source, SymbolTable *symbols) {
+            Lexer lexer(source, 0, symbols);
+            TokenBlock block;
+
+            auto emit = [&](TokenType type, size_t offset, size_t length, uint32_t payload) {
+                block.kinds[block.count] = static_cast<uint8_t>(type);
+                block.offsets[block.count] = static_cast<uint32_t>(offset);
+                block.lengths[block.count] = static_cast<uint32_t>(length);
+                block.payloads[block.count] = payload;
+
+                if (++block.count == TokenBlock::capacity) {
+                    blocks.push(block);
+                    block.count = 0;
+                }
+            };
+
+            while (lexer.hasNext()) {
+                size_t start = lexer.getIndex();
+                auto token = lexer.next();
+
+                if (!token.has_value()) {
+                    emit(TokenType::INVALID, start, lexer.getIndex() - start, 0);
+                    continue;
+                }
+
+                if (hasLiteral(token->type))
+                    literals.push(token->literal);
+
+                emit(token->type, token->offset, token->value.length(), token->payload);
+            }
+
+            emit(TokenType::EOI, source.length(), 0, 0);
+
+            if (block.count != 0)
+                blocks.push(block);
+        }
+
+    public:
+        // Starts lexing `buffer.source` into `buffer`, which has to be empty.
+        TokenPipe(TokenBuffer &buffer, SymbolTable *symbols): buffer(buffer) {
+            producer = std::thread([this, source = buffer.source, symbols] { produce(source, symbols); });
+        }
+
+        TokenPipe(const TokenPipe &) = delete;
+        TokenPipe &operator=(const TokenPipe &) = delete;
+
+        ~TokenPipe() override {
+            finish();
+        }
+
+        void pull() override {
+            TokenBlock block = blocks.pop();
+
+            for (uint8_t i = 0; i < block.count; i++) {
+                auto type = static_cast<TokenType>(block.kinds[i]);
+                uint32_t payload = block.payloads[i];
+
+                if (hasLiteral(type)) {
+                    payload = static_cast<uint32_t>(buffer.literals.size());
+                    buffer.literals.push_back(literals.pop());
+                }
+
+                buffer.push(type, block.offsets[i], block.lengths[i], payload);
+            }
+        }
+
+        // Drains the rest of the tokens, so the buffer ends in EOI, and joins
+        // the lexer thread.
+        void finish() {
+            if (!producer.joinable())
+                return;
+
+            while (buffer.size() == 0 || buffer.kind(buffer.size() - 1) != TokenType::EOI)
+                pull();
+
+            producer.join();
+        }
+    };
+
+    // Lexes `source` into `buffer` and parses it at the same time, the lexer
+    // running on a thread of its own. Yields the same buffer as lexAll() and
+    // the same tree as parse() over it, in about the time of the slower of
+    // the two stages instead of their sum. Only worth a thread for large
+    // sources.
+    inline Ast parsePipelined(std::string_view source, TokenBuffer &buffer, Arena &arena,
+                              SymbolTable *symbols = nullptr) {
+        assert(source.length() <= std::numeric_limits<uint32_t>::max());
+
+        buffer = TokenBuffer{};
+        buffer.source = source;
+        buffer.reserve(source.length() / 4 + 1);
+
+        TokenPipe pipe(buffer, symbols);
+        Ast ast = Parser(buffer, arena, &pipe).parse();
+        pipe.finish();
+        return ast;
+    }
+}
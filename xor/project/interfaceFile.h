@@ -0,0 +1,565 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../io/atomicFile.h"
+#include "../io/sourceFile.h"
+#include "../parser/ast.h"
+#include "../util/hash.h"
+
+namespace xorLang {
+    enum class SymbolKind : uint8_t {
+        FUNCTION, OPERATOR, CONVERSION, CLASS, FIELD
+    };
+
+    // A public declaration of a library, as written to its interface file.
+    // Members are named after their class, e.g. `String::length`, operators
+    // `op+` and conversions `cnv`; overloads share a name. Types are spelled
+    // as in the source, empty for none.
+    struct ExportedParameter {
+        std::string name;
+        std::string type;
+        uint8_t modifiers = 0;
+    };
+
+    struct ExportedSymbol {
+        SymbolKind kind = SymbolKind::FUNCTION;
+        uint8_t modifiers = 0;
+        std::string name;
+        // Return type, field type, conversion target or base class
+        std::string type;
+        std::vector<ExportedParameter> parameters;
+    };
+
+    // The same, read in place from a mapped interface file.
+    struct InterfaceParameter {
+        std::string_view name;
+        std::string_view type;
+        uint8_t modifiers;
+    };
+
+    struct InterfaceSymbol {
+        SymbolKind kind;
+        uint8_t modifiers;
+        std::string_view name;
+        std::string_view type;
+        uint32_t parameters;
+        uint32_t parameterCount;
+    };
+
+    namespace detail::interface {
+        inline constexpr char magic[8] = {'X', 'O', 'R', 'H', 'D', 'R', 'S', '\n'};
+        inline constexpr uint32_t format = 1;
+        inline constexpr uint32_t byteOrder = 0x01020304;
+        inline constexpr uint64_t hashSeed = 0x786F722D68647273ull;
+
+        struct Header {
+            char magic[8];
+            uint32_t format;
+            uint32_t byteOrder;
+            uint32_t symbols;
+            uint32_t parameters;
+            // Directory size, a power of two
+            uint32_t slots;
+            uint32_t stringBytes;
+            uint32_t library;
+            uint32_t libraryLength;
+        };
+
+        static_assert(sizeof(Header) == 40);
+
+        // A directory entry: the symbols named `hash`, which are adjacent
+        // since symbols are sorted by name. Empty when `count` is 0.
+        struct Slot {
+            uint64_t hash;
+            uint32_t first;
+            uint32_t count;
+        };
+
+        static_assert(sizeof(Slot) == 16);
+
+        // Strings are offsets into the string section.
+        struct SymbolRecord {
+            uint32_t name;
+            uint32_t nameLength;
+            uint32_t type;
+            uint32_t typeLength;
+            uint32_t parameters;
+            uint16_t parameterCount;
+            uint8_t kind;
+            uint8_t modifiers;
+        };
+
+        static_assert(sizeof(SymbolRecord) == 24);
+
+        struct ParameterRecord {
+            uint32_t name;
+            uint32_t nameLength;
+            uint32_t type;
+            uint32_t typeLength;
+            uint8_t modifiers;
+            uint8_t padding[3];
+        };
+
+        static_assert(sizeof(ParameterRecord) == 20);
+
+        constexpr size_t align(size_t offset) {
+            return (offset + 63) & ~size_t{63};
+        }
+
+        struct Layout {
+            size_t slots, symbols, parameters, strings, end;
+
+            explicit Layout(const Header &header) {
+                slots = align(sizeof(Header));
+                symbols = align(slots + size_t{header.slots} * sizeof(Slot));
+                parameters = align(symbols + size_t{header.symbols} * sizeof(SymbolRecord));
+                strings = align(parameters + size_t{header.parameters} * sizeof(ParameterRecord));
+                end = strings + header.stringBytes;
+            }
+        };
+
+        inline uint64_t hashName(std::string_view name) {
+            return hashBytes(name, hashSeed);
+        }
+
+        // Spells a type node the way it is written, e.g. `&std::String[]`; the
+        // type of `&this` is `&`.
+        inline std::string typeName(const Ast &ast, NodeId id) {
+            if (id == noNode)
+                return {};
+
+            const Node &node = ast.node(id);
+
+            switch (node.kind) {
+                case NodeKind::TYPE_NAME: {
+                    std::string name;
+
+                    for (uint32_t i = 0; i < ast.listSize(node.a); i++) {
+                        if (i > 0)
+                            name += "::";
+
+                        name += ast.text(ast.listItem(node.a, i));
+                    }
+
+                    return name;
+                }
+                case NodeKind::ARRAY_TYPE:
+                    return typeName(ast, node.a) + "[]";
+                case NodeKind::REFERENCE_TYPE:
+                    return "&" + typeName(ast, node.a);
+                default:
+                    return {};
+            }
+        }
+
+        inline void exportDeclaration(const Ast &ast, NodeId id, std::string_view scope,
+                                      std::vector<ExportedSymbol> &symbols) {
+            const Node &node = ast.node(id);
+
+            if ((node.modifiers & MOD_PUBLIC) == 0 || node.token == noToken)
+                return;
+
+            ExportedSymbol symbol;
+            symbol.modifiers = node.modifiers;
+            symbol.name = scope;
+
+            switch (node.kind) {
+                case NodeKind::FUNCTION:
+                    symbol.kind = SymbolKind::FUNCTION;
+                    symbol.name += ast.text(node.token);
+                    break;
+                case NodeKind::OPERATOR:
+                    symbol.kind = SymbolKind::OPERATOR;
+                    symbol.name += "op";
+                    symbol.name += ast.text(node.token);
+
+                    if (ast.tokens->kind(node.token) == TokenType::L_BRACKET)
+                        symbol.name += "]";
+                    break;
+                case NodeKind::CONVERSION:
+                    symbol.kind = SymbolKind::CONVERSION;
+                    symbol.name += "cnv";
+                    symbol.type = typeName(ast, node.a);
+                    break;
+                case NodeKind::FIELD:
+                    symbol.kind = SymbolKind::FIELD;
+                    symbol.name += ast.text(node.token);
+                    symbol.type = typeName(ast, node.a);
+                    break;
+                case NodeKind::CLASS:
+                    symbol.kind = SymbolKind::CLASS;
+                    symbol.name += ast.text(node.token);
+
+                    if (node.b != 0)
+                        symbol.type = typeName(ast, ast.extra[node.b]);
+                    break;
+                default:
+                    return;
+            }
+
+            if (node.kind == NodeKind::FUNCTION || node.kind == NodeKind::OPERATOR) {
+                ExtraId parameters = ast.extra[node.a];
+                symbol.type = typeName(ast, ast.extra[node.a + 1]);
+
+                for (uint32_t i = 0; i < ast.listSize(parameters); i++) {
+                    const Node &parameter = ast.node(ast.listItem(parameters, i));
+
+                    if (parameter.kind != NodeKind::PARAMETER || parameter.token == noToken)
+                        continue;
+
+                    symbol.parameters.push_back(ExportedParameter{
+                            std::string(ast.text(parameter.token)), typeName(ast, parameter.a), parameter.modifiers
+                    });
+                }
+            }
+
+            if (node.kind == NodeKind::CLASS) {
+                std::string members = symbol.name + "::";
+
+                for (uint32_t i = 0; i < ast.listSize(node.a); i++)
+                    exportDeclaration(ast, ast.listItem(node.a, i), members, symbols);
+            }
+
+            symbols.push_back(std::move(symbol));
+        }
+    }
+
+    // Appends the public declarations of a file, and the public members of
+    // its public classes, to `symbols`.
+    inline void collectExports(const Ast &ast, std::vector<ExportedSymbol> &symbols) {
+        if (ast.nodes.size() == 0)
+            return;
+
+        const Node &file = ast.node(0);
+
+        for (uint32_t i = 0; i < ast.listSize(file.a); i++)
+            detail::interface::exportDeclaration(ast, ast.listItem(file.a, i), {}, symbols);
+    }
+
+    // An `import` declaration of a file: `lib::Class::member` with the segments
+    // joined by `::`, or the quoted path of `import "file.xor"`, and the
+    // bytes it spans in the source.
+    struct ImportPath {
+        std::string path;
+        bool quoted = false;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    inline void collectImports(const Ast &ast, std::vector<ImportPath> &imports) {
+        if (ast.nodes.size() == 0)
+            return;
+
+        const Node &file = ast.node(0);
+
+        for (uint32_t i = 0; i < ast.listSize(file.a); i++) {
+            const Node &declaration = ast.node(ast.listItem(file.a, i));
+
+            if (declaration.kind != NodeKind::IMPORT)
+                continue;
+
+            const Node &target = ast.node(declaration.a);
+            ImportPath import;
+            TokenId first = target.token;
+            TokenId last = first;
+
+            if (target.kind == NodeKind::LITERAL) {
+                std::string_view text = ast.text(first);
+                import.path = text.substr(1, text.length() >= 2 ? text.length() - 2 : 0);
+                import.quoted = true;
+            } else if (target.kind == NodeKind::PATH) {
+                for (uint32_t j = 0; j < ast.listSize(target.a); j++) {
+                    if (j > 0)
+                        import.path += "::";
+
+                    last = ast.listItem(target.a, j);
+                    import.path += ast.text(last);
+                }
+            } else {
+                continue;
+            }
+
+            import.offset = ast.tokens->offset(first);
+            import.length = ast.tokens->offset(last) + ast.tokens->lengths[last] - import.offset;
+            imports.push_back(std::move(import));
+        }
+    }
+
+    // Writes the interface of `library` for `xor -ih`. The file is a header,
+    // a hashed directory of symbol names, the symbols sorted by name, their
+    // parameters and one section of deduplicated strings, each section on a
+    // cache line. Readers map it and only touch the directory slots and
+    // records of the names they look up. False when it could not be written.
+    inline bool writeInterface(const std::string &path, std::string_view library,
+                               std::vector<ExportedSymbol> symbols) {
+        using namespace detail::interface;
+
+        std::stable_sort(symbols.begin(), symbols.end(), [](const ExportedSymbol &a, const ExportedSymbol &b) {
+            return a.name < b.name;
+        });
+
+        std::string strings;
+        std::unordered_map<std::string, uint32_t> offsets;
+
+        auto intern = [&](const std::string &text) {
+            auto [it, inserted] = offsets.try_emplace(text, static_cast<uint32_t>(strings.size()));
+
+            if (inserted)
+                strings += text;
+
+            return it->second;
+        };
+
+        std::vector<SymbolRecord> records;
+        std::vector<ParameterRecord> parameters;
+        records.reserve(symbols.size());
+
+        for (const ExportedSymbol &symbol : symbols) {
+            if (symbol.parameters.size() > UINT16_MAX)
+                return false;
+
+            records.push_back(SymbolRecord{
+                    intern(symbol.name), static_cast<uint32_t>(symbol.name.length()),
+                    intern(symbol.type), static_cast<uint32_t>(symbol.type.length()),
+                    static_cast<uint32_t>(parameters.size()), static_cast<uint16_t>(symbol.parameters.size()),
+                    static_cast<uint8_t>(symbol.kind), symbol.modifiers
+            });
+
+            for (const ExportedParameter &parameter : symbol.parameters) {
+                parameters.push_back(ParameterRecord{
+                        intern(parameter.name), static_cast<uint32_t>(parameter.name.length()),
+                        intern(parameter.type), static_cast<uint32_t>(parameter.type.length()),
+                        parameter.modifiers, {}
+                });
+            }
+        }
+
+        // At most half full, so a probe for a missing name ends quickly
+        std::vector<Slot> slots(std::bit_ceil(symbols.size() * 2 + 1), Slot{});
+        size_t mask = slots.size() - 1;
+
+        for (size_t i = 0; i < symbols.size();) {
+            size_t end = i + 1;
+
+            while (end < symbols.size() && symbols[end].name == symbols[i].name)
+                end++;
+
+            uint64_t hash = hashName(symbols[i].name);
+            size_t at = hash & mask;
+
+            while (slots[at].count != 0)
+                at = (at + 1) & mask;
+
+            slots[at] = Slot{hash, static_cast<uint32_t>(i), static_cast<uint32_t>(end - i)};
+            i = end;
+        }
+
+        Header header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.format = format;
+        header.byteOrder = byteOrder;
+        header.symbols = static_cast<uint32_t>(records.size());
+        header.parameters = static_cast<uint32_t>(parameters.size());
+        header.slots = static_cast<uint32_t>(slots.size());
+        header.library = intern(std::string(library));
+        header.libraryLength = static_cast<uint32_t>(library.length());
+        header.stringBytes = static_cast<uint32_t>(strings.size());
+
+        Layout layout(header);
+        AtomicFile out(path);
+
+        out.write(&header, sizeof(Header));
+        out.padTo(layout.slots);
+        out.write(slots.data(), slots.size() * sizeof(Slot));
+        out.padTo(layout.symbols);
+        out.write(records.data(), records.size() * sizeof(SymbolRecord));
+        out.padTo(layout.parameters);
+        out.write(parameters.data(), parameters.size() * sizeof(ParameterRecord));
+        out.padTo(layout.strings);
+        out.write(strings.data(), strings.size());
+
+        return out.size() == layout.end && out.commit();
+    }
+
+    // A library interface written by writeInterface(), mapped for lookups.
+    // Opening only checks the header and the file size; records are checked
+    // as they are read, so a lookup costs a few cache lines however large the
+    // library is, and a corrupt record reads as a missing symbol.
+    class InterfaceFile {
+        SourceFile file;
+        detail::interface::Header header{};
+        size_t slots = 0, symbols = 0, parameters = 0, strings = 0;
+
+        explicit InterfaceFile(SourceFile file): file(std::move(file)) {}
+
+        [[nodiscard]] const char *data() const {
+            return file.view().data();
+        }
+
+        template<typename T>
+        [[nodiscard]] T read(size_t section, size_t index) const {
+            T item;
+            std::memcpy(&item, data() + section + index * sizeof(T), sizeof(T));
+            return item;
+        }
+
+        [[nodiscard]] std::optional<std::string_view> string(uint32_t offset, uint32_t length) const {
+            if (offset > header.stringBytes || length > header.stringBytes - offset)
+                return std::nullopt;
+
+            return std::string_view(data() + strings + offset, length);
+        }
+
+    public:
+        static std::optional<InterfaceFile> open(const std::string &path) {
+            using namespace detail::interface;
+
+            std::optional<SourceFile> file = SourceFile::open(path, FileAccess::RANDOM);
+
+            if (!file.has_value() || file->view().length() < sizeof(Header))
+                return std::nullopt;
+
+            InterfaceFile result(std::move(*file));
+            std::memcpy(&result.header, result.data(), sizeof(Header));
+            const Header &header = result.header;
+
+            if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.format != format ||
+                header.byteOrder != byteOrder || !std::has_single_bit(header.slots))
+                return std::nullopt;
+
+            Layout layout(header);
+
+            if (result.file.view().length() != layout.end ||
+                !result.string(header.library, header.libraryLength).has_value())
+                return std::nullopt;
+
+            result.slots = layout.slots;
+            result.symbols = layout.symbols;
+            result.parameters = layout.parameters;
+            result.strings = layout.strings;
+            return result;
+        }
+
+        [[nodiscard]] std::string_view library() const {
+            return *string(header.library, header.libraryLength);
+        }
+
+        [[nodiscard]] size_t symbolCount() const {
+            return header.symbols;
+        }
+
+        // The symbols named `name`, as indices [first, first + count); count is
+        // 0 when the library has none.
+        [[nodiscard]] std::pair<uint32_t, uint32_t> find(std::string_view name) const {
+            using namespace detail::interface;
+
+            uint64_t hash = hashName(name);
+            size_t mask = header.slots - 1;
+
+            for (size_t at = hash & mask, probes = 0; probes < header.slots; at = (at + 1) & mask, probes++) {
+                auto slot = read<Slot>(slots, at);
+
+                if (slot.count == 0)
+                    break;
+
+                if (slot.hash != hash || slot.first >= header.symbols || slot.count > header.symbols - slot.first)
+                    continue;
+
+                std::optional<InterfaceSymbol> first = symbol(slot.first);
+
+                if (first.has_value() && first->name == name)
+                    return {slot.first, slot.count};
+            }
+
+            return {0, 0};
+        }
+
+        // Whether an import of `name` from this library resolves: a symbol, the
+        // members of one with `Class::*`, or everything for `*` or nothing.
+        [[nodiscard]] bool contains(std::string_view name) const {
+            if (name.empty() || name == "*")
+                return true;
+
+            if (name.ends_with("::*"))
+                name.remove_suffix(3);
+
+            return find(name).second != 0;
+        }
+
+        // Symbol `index`, or nullopt when its record is out of bounds.
+        [[nodiscard]] std::optional<InterfaceSymbol> symbol(uint32_t index) const {
+            using namespace detail::interface;
+
+            if (index >= header.symbols)
+                return std::nullopt;
+
+            auto record = read<SymbolRecord>(symbols, index);
+            std::optional<std::string_view> name = string(record.name, record.nameLength);
+            std::optional<std::string_view> type = string(record.type, record.typeLength);
+
+            if (!name.has_value() || !type.has_value() || record.kind > static_cast<uint8_t>(SymbolKind::FIELD) ||
+                record.parameters > header.parameters ||
+                record.parameterCount > header.parameters - record.parameters)
+                return std::nullopt;
+
+            return InterfaceSymbol{
+                    static_cast<SymbolKind>(record.kind), record.modifiers, *name, *type, record.parameters,
+                    record.parameterCount
+            };
+        }
+
+        // Parameter `i` of `symbol`.
+        [[nodiscard]] std::optional<InterfaceParameter> parameter(const InterfaceSymbol &symbol, uint32_t i) const {
+            using namespace detail::interface;
+
+            if (i >= symbol.parameterCount)
+                return std::nullopt;
+
+            auto record = read<ParameterRecord>(parameters, symbol.parameters + i);
+            std::optional<std::string_view> name = string(record.name, record.nameLength);
+            std::optional<std::string_view> type = string(record.type, record.typeLength);
+
+            if (!name.has_value() || !type.has_value())
+                return std::nullopt;
+
+            return InterfaceParameter{*name, *type, record.modifiers};
+        }
+    };
+
+    // The interfaces passed with `-ih`, by library name.
+    class InterfaceSet {
+        std::map<std::string, InterfaceFile, std::less<>> libraries;
+
+    public:
+        // Null when the file is not a readable interface. A later interface
+        // of the same library replaces an earlier one.
+        const InterfaceFile *add(const std::string &path) {
+            std::optional<InterfaceFile> file = InterfaceFile::open(path);
+
+            if (!file.has_value())
+                return nullptr;
+
+            std::string name(file->library());
+            return &libraries.insert_or_assign(std::move(name), std::move(*file)).first->second;
+        }
+
+        [[nodiscard]] const InterfaceFile *find(std::string_view library) const {
+            auto it = libraries.find(library);
+            return it != libraries.end() ? &it->second : nullptr;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return libraries.empty();
+        }
+    };
+}
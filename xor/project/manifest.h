@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace xorLang {
+    struct SourceEntry {
+        std::filesystem::path path;
+        uintmax_t size;
+    };
+
+    // A project manifest (`xor.ini`): `[section]` headers followed by `key=value`
+    // pairs, with `#` and `;` starting comment lines.
+    class Manifest {
+        std::filesystem::path root;
+        std::map<std::string, std::string, std::less<>> values;
+
+        static std::string_view trim(std::string_view text) {
+            size_t start = text.find_first_not_of(" \t\r");
+
+            if (start == std::string_view::npos)
+                return {};
+
+            return text.substr(start, text.find_last_not_of(" \t\r") + 1 - start);
+        }
+
+    public:
+        // Accepts either the manifest itself or the directory holding `xor.ini`.
+        static std::optional<Manifest> load(const std::filesystem::path &path) {
+            std::error_code error;
+            std::filesystem::path file = std::filesystem::is_directory(path, error) ? path / "xor.ini" : path;
+            std::ifstream input(file);
+
+            if (!input.is_open())
+                return std::nullopt;
+
+            Manifest manifest;
+            manifest.root = file.parent_path();
+
+            std::string line;
+            std::string section;
+
+            while (std::getline(input, line)) {
+                std::string_view text = trim(line);
+
+                if (text.empty() || text[0] == '#' || text[0] == ';')
+                    continue;
+
+                if (text.front() == '[' && text.back() == ']') {
+                    section = trim(text.substr(1, text.length() - 2));
+                    continue;
+                }
+
+                size_t equals = text.find('=');
+
+                if (equals == std::string_view::npos)
+                    continue;
+
+                std::string key = section + "." + std::string(trim(text.substr(0, equals)));
+                manifest.values[key] = trim(text.substr(equals + 1));
+            }
+
+            return manifest;
+        }
+
+        // Looks up `key` in `section`, e.g. get("compiler", "sources").
+        [[nodiscard]] std::optional<std::string_view> get(std::string_view section, std::string_view key) const {
+            std::string name = std::string(section) + "." + std::string(key);
+            auto it = values.find(name);
+
+            if (it == values.end())
+                return std::nullopt;
+
+            return std::string_view(it->second);
+        }
+
+        [[nodiscard]] const std::filesystem::path &getRoot() const {
+            return root;
+        }
+
+        // Directory the `[compiler] sources` path points at, relative to `basePath`.
+        [[nodiscard]] std::filesystem::path sourcesPath() const {
+            std::filesystem::path base = root / std::string(get("compiler", "basePath").value_or("./"));
+            return (base / std::string(get("compiler", "sources").value_or("src/"))).lexically_normal();
+        }
+
+        // Every `.xor` file below the sources path, in path order.
+        [[nodiscard]] std::vector<SourceEntry> sourceFiles() const {
+            std::vector<SourceEntry> files;
+            std::error_code error;
+
+            for (auto it = std::filesystem::recursive_directory_iterator(sourcesPath(), error);
+                 !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+                if (it->is_regular_file(error) && it->path().extension() == ".xor")
+                    files.push_back(SourceEntry{it->path(), it->file_size(error)});
+            }
+
+            std::sort(files.begin(), files.end(), [](const SourceEntry &a, const SourceEntry &b) {
+                return a.path < b.path;
+            });
+
+            return files;
+        }
+    };
+}
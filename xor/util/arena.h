@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace xorLang {
+    // A bump allocator over a list of blocks. Allocations are never freed one by
+    // one and never move; reset() releases everything at once but keeps the
+    // first block for reuse.
+    class Arena {
+        static constexpr size_t blockSize = 64 * 1024;
+
+        std::vector<std::unique_ptr<std::byte[]>> blocks;
+        std::byte *current = nullptr;
+        size_t remaining = 0;
+
+    public:
+        Arena() = default;
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+        Arena(Arena &&) noexcept = default;
+        Arena &operator=(Arena &&) noexcept = default;
+
+        void *allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+            auto address = reinterpret_cast<uintptr_t>(current);
+            size_t padding = (alignment - address % alignment) % alignment;
+
+            if (current == nullptr || padding + size > remaining) {
+                // Oversized requests get a block of their own
+                size_t capacity = std::max(blockSize, size + alignment);
+                blocks.push_back(std::make_unique<std::byte[]>(capacity));
+                current = blocks.back().get();
+                remaining = capacity;
+
+                address = reinterpret_cast<uintptr_t>(current);
+                padding = (alignment - address % alignment) % alignment;
+            }
+
+            std::byte *result = current + padding;
+            current = result + size;
+            remaining -= padding + size;
+            return result;
+        }
+
+        template<typename T>
+        T *allocate(size_t count) {
+            return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        // Copies `text` into the arena; the view stays valid until reset().
+        std::string_view copy(std::string_view text) {
+            if (text.empty())
+                return {};
+
+            char *target = allocate<char>(text.length());
+            std::memcpy(target, text.data(), text.length());
+            return {target, text.length()};
+        }
+
+        void reset() {
+            if (blocks.empty())
+                return;
+
+            blocks.resize(1);
+            current = blocks.front().get();
+            remaining = blockSize;
+        }
+    };
+
+    // A growable array whose storage lives in an Arena. Growing copies the
+    // elements into a block twice the size and abandons the old one to the
+    // arena, so nothing is ever freed on its own: the whole array goes away
+    // with the arena's reset(). Only for trivially copyable elements.
+    template<typename T>
+    class ArenaVector {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        Arena *arena = nullptr;
+        T *items = nullptr;
+        uint32_t count = 0;
+        uint32_t capacity = 0;
+
+    public:
+        ArenaVector() = default;
+
+        explicit ArenaVector(Arena &arena, uint32_t capacity = 0): arena(&arena) {
+            reserve(capacity);
+        }
+
+        void reserve(uint32_t wanted) {
+            if (wanted <= capacity)
+                return;
+
+            T *grown = arena->allocate<T>(wanted);
+
+            if (count != 0)
+                std::memcpy(grown, items, sizeof(T) * count);
+
+            items = grown;
+            capacity = wanted;
+        }
+
+        uint32_t push(const T &item) {
+            if (count == capacity)
+                reserve(std::max<uint32_t>(16, capacity * 2));
+
+            items[count] = item;
+            return count++;
+        }
+
+        [[nodiscard]] uint32_t size() const {
+            return count;
+        }
+
+        T &operator[](uint32_t i) {
+            return items[i];
+        }
+
+        const T &operator[](uint32_t i) const {
+            return items[i];
+        }
+
+        const T *begin() const {
+            return items;
+        }
+
+        const T *end() const {
+            return items + count;
+        }
+    };
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace xorLang {
+    inline uint64_t hashMix(uint64_t x) {
+        x ^= x >> 32;
+        x *= 0xD6E8FEB86659FD93ull;
+        x ^= x >> 32;
+        x *= 0xD6E8FEB86659FD93ull;
+        return x ^ (x >> 32);
+    }
+
+    // A fast non-cryptographic 64-bit hash, eight bytes per multiply.
+    inline uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0) {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        uint64_t hash = seed ^ (size * 0x9E3779B97F4A7C15ull);
+
+        for (; size >= 8; bytes += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes, 8);
+            hash = (hash ^ word) * 0xD6E8FEB86659FD93ull;
+            hash ^= hash >> 29;
+        }
+
+        if (size > 0) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes, size);
+            hash = (hash ^ word) * 0xD6E8FEB86659FD93ull;
+        }
+
+        return hashMix(hash);
+    }
+
+    inline uint64_t hashBytes(std::string_view text, uint64_t seed = 0) {
+        return hashBytes(text.data(), text.length(), seed);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+namespace xorLang {
+    // Collects output in a large buffer and hands it to write(2) in big blocks,
+    // bypassing stdio and iostream entirely.
+    class OutputBuffer {
+        int fd;
+        std::vector<char> buffer;
+        size_t used = 0;
+        bool failed = false;
+
+        void writeAll(const char *data, size_t size) {
+            while (size > 0 && !failed) {
+                ssize_t written = ::write(fd, data, size);
+
+                if (written < 0 && errno == EINTR)
+                    continue;
+
+                if (written <= 0) {
+                    failed = true;
+                    return;
+                }
+
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+        }
+
+    public:
+        explicit OutputBuffer(int fd, size_t capacity = 1 << 20): fd(fd), buffer(capacity) {}
+
+        OutputBuffer(const OutputBuffer &) = delete;
+        OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+        ~OutputBuffer() {
+            flush();
+        }
+
+        void append(std::string_view text) {
+            if (used + text.length() > buffer.size()) {
+                flush();
+
+                // Too large to be worth copying, write it straight through
+                if (text.length() >= buffer.size()) {
+                    writeAll(text.data(), text.length());
+                    return;
+                }
+            }
+
+            std::memcpy(buffer.data() + used, text.data(), text.length());
+            used += text.length();
+        }
+
+        void flush() {
+            writeAll(buffer.data(), used);
+            used = 0;
+        }
+
+        // False once any write failed, e.g. because the reader closed the pipe.
+        [[nodiscard]] bool good() const {
+            return !failed;
+        }
+    };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace xorLang {
+    // A bounded lock-free queue between exactly one producer and one consumer
+    // thread. Each index lives on its own cache line next to the owner's stale
+    // copy of the other index, so the shared lines only move between cores
+    // when the ring looks full to the producer or empty to the consumer.
+    template<typename T>
+    class SpscRing {
+        static constexpr size_t cacheLine = 64;
+
+        std::unique_ptr<T[]> slots;
+        size_t mask;
+
+        // Next slot to read, and the consumer's copy of `tail`
+        alignas(cacheLine) std::atomic<size_t> head{0};
+        size_t knownTail = 0;
+
+        // Next slot to write, and the producer's copy of `head`
+        alignas(cacheLine) std::atomic<size_t> tail{0};
+        size_t knownHead = 0;
+
+        // Spins briefly, then gives the core away: on a machine with fewer
+        // cores than busy threads the other side can only run if we yield.
+        static void backoff(unsigned &spins) {
+            if (++spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#endif
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+
+    public:
+        // `capacity` has to be a power of two.
+        explicit SpscRing(size_t capacity): slots(new T[capacity]), mask(capacity - 1) {
+            assert(capacity != 0 && (capacity & mask) == 0);
+        }
+
+        SpscRing(const SpscRing &) = delete;
+        SpscRing &operator=(const SpscRing &) = delete;
+
+        // Producer side, false when the ring is full.
+        bool tryPush(const T &item) {
+            size_t at = tail.load(std::memory_order_relaxed);
+
+            if (at - knownHead > mask) {
+                knownHead = head.load(std::memory_order_acquire);
+
+                if (at - knownHead > mask)
+                    return false;
+            }
+
+            slots[at & mask] = item;
+            tail.store(at + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, false when the ring is empty.
+        bool tryPop(T &item) {
+            size_t at = head.load(std::memory_order_relaxed);
+
+            if (at == knownTail) {
+                knownTail = tail.load(std::memory_order_acquire);
+
+                if (at == knownTail)
+                    return false;
+            }
+
+            item = slots[at & mask];
+            head.store(at + 1, std::memory_order_release);
+            return true;
+        }
+
+        void push(const T &item) {
+            for (unsigned spins = 0; !tryPush(item);)
+                backoff(spins);
+        }
+
+        T pop() {
+            T item;
+
+            for (unsigned spins = 0; !tryPop(item);)
+                backoff(spins);
+
+            return item;
+        }
+    };
+}
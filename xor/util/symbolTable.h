@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "hash.h"
+
+namespace xorLang {
+    // A 32-bit handle for an interned name; equal names always get equal IDs.
+    // Zero is never handed out and means "no symbol".
+    using SymbolId = uint32_t;
+
+    // Interns names into arena storage. The table is split into shards picked by
+    // the name's hash, each with its own lock, arena and open-addressing index,
+    // so threads lexing different files rarely contend and never take a global
+    // lock. An ID holds the shard in its low bits and the shard-local index + 1
+    // above them.
+    class SymbolTable {
+        static constexpr uint32_t shardBits = 6;
+        static constexpr uint32_t shardCount = 1u << shardBits;
+
+        struct Shard {
+            std::mutex mutex;
+            Arena arena;
+            std::vector<std::string_view> names;
+            std::vector<uint32_t> hashes;
+            // Index into `names` plus one, zero when empty; always a power of two
+            std::vector<uint32_t> slots = std::vector<uint32_t>(64, 0);
+
+            void grow() {
+                std::vector<uint32_t> larger(slots.size() * 2, 0);
+                size_t mask = larger.size() - 1;
+
+                for (size_t i = 0; i < names.size(); i++) {
+                    size_t slot = hashes[i] & mask;
+
+                    while (larger[slot] != 0)
+                        slot = (slot + 1) & mask;
+
+                    larger[slot] = static_cast<uint32_t>(i + 1);
+                }
+
+                slots = std::move(larger);
+            }
+        };
+
+        std::array<Shard, shardCount> shards;
+
+    public:
+        SymbolId intern(std::string_view name) {
+            uint64_t hash = hashBytes(name);
+            auto shardIndex = static_cast<uint32_t>(hash & (shardCount - 1));
+            auto probe = static_cast<uint32_t>(hash >> shardBits);
+            Shard &shard = shards[shardIndex];
+
+            std::lock_guard lock(shard.mutex);
+            size_t mask = shard.slots.size() - 1;
+            size_t slot = probe & mask;
+
+            while (shard.slots[slot] != 0) {
+                uint32_t index = shard.slots[slot] - 1;
+
+                if (shard.hashes[index] == probe && shard.names[index] == name)
+                    return ((index + 1) << shardBits) | shardIndex;
+
+                slot = (slot + 1) & mask;
+            }
+
+            auto index = static_cast<uint32_t>(shard.names.size());
+            shard.names.push_back(shard.arena.copy(name));
+            shard.hashes.push_back(probe);
+            shard.slots[slot] = index + 1;
+
+            // Keep the load factor under a half
+            if (shard.names.size() * 2 > shard.slots.size())
+                shard.grow();
+
+            return ((index + 1) << shardBits) | shardIndex;
+        }
+
+        // The interned spelling of `id`, valid for the lifetime of the table.
+        [[nodiscard]] std::string_view name(SymbolId id) {
+            Shard &shard = shards[id & (shardCount - 1)];
+            std::lock_guard lock(shard.mutex);
+            return shard.names[(id >> shardBits) - 1];
+        }
+
+        [[nodiscard]] size_t size() {
+            size_t count = 0;
+
+            for (Shard &shard : shards) {
+                std::lock_guard lock(shard.mutex);
+                count += shard.names.size();
+            }
+
+            return count;
+        }
+    };
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace xorLang {
+    // A fixed set of workers with one task deque each. Tasks are dealt round
+    // robin, a worker takes its own tasks from the front and, once it runs dry,
+    // steals from the back of the other deques. Submitting in decreasing order of
+    // cost therefore starts the largest tasks first on every worker.
+    class ThreadPool {
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex stateMutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        size_t pending = 0;
+        size_t next = 0;
+        bool stopping = false;
+
+        std::optional<std::function<void()>> take(size_t self) {
+            for (size_t i = 0; i < queues.size(); i++) {
+                Queue &queue = *queues[(self + i) % queues.size()];
+                std::lock_guard lock(queue.mutex);
+
+                if (queue.tasks.empty())
+                    continue;
+
+                std::function<void()> task;
+
+                if (i == 0) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                } else {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+
+                return task;
+            }
+
+            return std::nullopt;
+        }
+
+        void work(size_t self) {
+            while (true) {
+                if (auto task = take(self)) {
+                    (*task)();
+
+                    std::lock_guard lock(stateMutex);
+
+                    if (--pending == 0)
+                        idle.notify_all();
+
+                    continue;
+                }
+
+                std::unique_lock lock(stateMutex);
+
+                if (stopping)
+                    return;
+
+                // Tasks are queued under `stateMutex`, so a submit racing with the
+                // failed take() above is seen here rather than missed.
+                wake.wait(lock, [this] { return stopping || hasQueued(); });
+            }
+        }
+
+        bool hasQueued() {
+            for (const auto &queue : queues) {
+                std::lock_guard lock(queue->mutex);
+
+                if (!queue->tasks.empty())
+                    return true;
+            }
+
+            return false;
+        }
+
+    public:
+        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
+            threads = std::max<size_t>(threads, 1);
+
+            for (size_t i = 0; i < threads; i++)
+                queues.push_back(std::make_unique<Queue>());
+
+            for (size_t i = 0; i < threads; i++)
+                workers.emplace_back([this, i] { work(i); });
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(stateMutex);
+                stopping = true;
+            }
+
+            wake.notify_all();
+
+            for (auto &worker : workers)
+                worker.join();
+        }
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard lock(stateMutex);
+                Queue &queue = *queues[next++ % queues.size()];
+
+                pending++;
+                std::lock_guard queueLock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+
+            wake.notify_one();
+        }
+
+        // Blocks until every submitted task has finished.
+        void wait() {
+            std::unique_lock lock(stateMutex);
+            idle.wait(lock, [this] { return pending == 0; });
+        }
+
+        [[nodiscard]] size_t size() const {
+            return workers.size();
+        }
+    };
+}